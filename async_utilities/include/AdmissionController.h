@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// CoDel-style load shedding driven by queue sojourn time. Every task
+// reports how long it waited before starting; once the wait has stayed
+// above target for a whole interval the controller reports overload and
+// new work is refused until a task again starts within target. While
+// overloaded, one probe task per interval is still admitted so an idle
+// pool can leave the overloaded state.
+class AdmissionController {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit AdmissionController(std::chrono::microseconds target = std::chrono::milliseconds(5),
+                                 std::chrono::microseconds interval = std::chrono::milliseconds(100))
+        : m_target(target), m_interval(interval), m_firstAboveTime(0), m_overloaded(false), m_nextProbeTime(0),
+          m_admitted(0), m_rejected(0) {}
+
+    bool admit() {
+        if (m_overloaded.load(std::memory_order_relaxed) && !take_probe()) {
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_admitted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void record_sojourn(Clock::duration sojourn, Clock::time_point now = Clock::now()) {
+        if (sojourn < m_target) {
+            if (m_firstAboveTime.load(std::memory_order_relaxed) != 0) {
+                m_firstAboveTime.store(0, std::memory_order_relaxed);
+            }
+            if (m_overloaded.load(std::memory_order_relaxed)) {
+                m_overloaded.store(false, std::memory_order_relaxed);
+            }
+            return;
+        }
+
+        std::int64_t ticks = now.time_since_epoch().count();
+        std::int64_t firstAbove = m_firstAboveTime.load(std::memory_order_relaxed);
+        if (firstAbove == 0) {
+            std::int64_t deadline = (now + m_interval).time_since_epoch().count();
+            m_firstAboveTime.compare_exchange_strong(firstAbove, deadline, std::memory_order_relaxed);
+        } else if (ticks >= firstAbove && !m_overloaded.load(std::memory_order_relaxed)) {
+            m_nextProbeTime.store((now + m_interval).time_since_epoch().count(), std::memory_order_relaxed);
+            m_overloaded.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    bool is_overloaded() const {
+        return m_overloaded.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t admitted_count() const {
+        return m_admitted.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t rejected_count() const {
+        return m_rejected.load(std::memory_order_relaxed);
+    }
+
+private:
+    bool take_probe() {
+        Clock::time_point now = Clock::now();
+        std::int64_t next = m_nextProbeTime.load(std::memory_order_relaxed);
+        return now.time_since_epoch().count() >= next &&
+               m_nextProbeTime.compare_exchange_strong(next, (now + m_interval).time_since_epoch().count(),
+                                                       std::memory_order_relaxed);
+    }
+
+    const Clock::duration m_target;
+    const Clock::duration m_interval;
+    std::atomic<std::int64_t> m_firstAboveTime;
+    std::atomic<bool> m_overloaded;
+    std::atomic<std::int64_t> m_nextProbeTime;
+    std::atomic<std::uint64_t> m_admitted;
+    std::atomic<std::uint64_t> m_rejected;
+};
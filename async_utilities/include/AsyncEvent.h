@@ -0,0 +1,70 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "CancellationToken.h"
+#include "ThreadPool.h"
+#include "WaiterList.h"
+
+// Manual-reset event. Continuations passed to wait() run inline while the
+// event is set and are otherwise resumed on the pool by the next set().
+class AsyncEvent {
+public:
+    using Continuation = std::function<void()>;
+
+    explicit AsyncEvent(ThreadPool& threadPool, bool initially_set = false)
+        : m_threadPool(threadPool), m_set(initially_set) {}
+
+    AsyncEvent(const AsyncEvent&) = delete;
+    AsyncEvent& operator=(const AsyncEvent&) = delete;
+
+    void set() {
+        std::vector<detail::Waiter> released;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_set = true;
+            while (std::optional<detail::Waiter> waiter = m_waiters.pop()) {
+                released.push_back(std::move(*waiter));
+            }
+        }
+        for (auto& waiter : released) {
+            m_threadPool.post_or_run(std::move(waiter.resume));
+        }
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_set = false;
+    }
+
+    bool is_set() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_set;
+    }
+
+    void wait(Continuation continuation, const CancellationToken& token = CancellationToken()) {
+        if (token.is_cancellation_requested()) {
+            return;
+        }
+        detail::WaiterList::Id id = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_set) {
+                id = m_waiters.push(std::move(continuation));
+            }
+        }
+        if (id == 0) {
+            continuation();
+            return;
+        }
+        m_waiters.watch(m_mutex, id, token);
+    }
+
+private:
+    ThreadPool& m_threadPool;
+    mutable std::mutex m_mutex;
+    bool m_set;
+    detail::WaiterList m_waiters;
+};
@@ -1,148 +1,81 @@
 #pragma once
 
-#include <iostream>
-#include <future>
 #include <optional>
-#include <sstream>
 #include <memory>
-#include <atomic>
 
-#include "ThreadPool.h"
-#include "CallbackDispatcher.h"
+#include "Executor.h"
 
+// Typed front end kept for existing callers. All instantiations share the
+// pipeline of the underlying Executor.
 template<typename T>
-class CancellableOperation {
+class AsyncExecutor {
 public:
-    using Operation = std::function<T()>;
-    using Callback = std::function<void(T)>;
+    using AsyncOperation = std::function<T()>;
+    using CancellableAsyncOperation = std::function<T(const CancellationToken&)>;
+    using Callback = typename CancellableOperation<T>::Callback;
+    using ExceptionCallback = Executor::ExceptionCallback;
 
-    explicit CancellableOperation(Operation op, std::optional<Callback> cb)
-        : m_operation(std::move(op)), m_callback(std::move(cb)), m_isCancelled(false), m_isFinished(false), m_ResultPromise(std::make_shared<std::promise<T>>()) {}
+    AsyncExecutor(ThreadPool& threadPool, CallbackDispatcher& dispatcher, ExecutionPolicy policy = ExecutionPolicy())
+        : m_executor(threadPool, dispatcher, policy) {}
 
-    T execute() {
-        if (!m_isCancelled.load(std::memory_order_acquire)) {
-            T result = m_operation();
-            setPromiseValue(result);
-            return result;
-        }
-        throw std::runtime_error("Operation cancelled");
-    }
+    explicit AsyncExecutor(const Executor& executor)
+        : m_executor(executor) {}
 
-    void callback(const T& value) {
-        if (!m_isCancelled.load(std::memory_order_acquire) && !m_isFinished.exchange(true)) {
-            if(m_callback) {
-                (*m_callback)(value);
-            }
-        }
+    std::shared_ptr<CancellableOperation<T>> start(AsyncOperation operation, std::optional<Callback> callback = std::nullopt,
+                                                   const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                                                   const CancellationToken& parent_token = CancellationToken()) {
+        return m_executor.submit(std::move(operation), std::move(callback), exception_callback, parent_token);
     }
 
-    void cancel() {
-        m_isCancelled.store(true, std::memory_order_release);
+    // The operation receives a token that is cancelled by
+    // CancellableOperation::cancel() or by cancelling parent_token.
+    std::shared_ptr<CancellableOperation<T>> start(CancellableAsyncOperation operation, std::optional<Callback> callback = std::nullopt,
+                                                   const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                                                   const CancellationToken& parent_token = CancellationToken()) {
+        return m_executor.submit(std::move(operation), std::move(callback), exception_callback, parent_token);
     }
 
-    bool isCancelled() const {
-        return m_isCancelled.load(std::memory_order_acquire);
+    // Returns nullptr if the thread pool refuses the operation instead of
+    // throwing or blocking.
+    std::shared_ptr<CancellableOperation<T>> try_start(AsyncOperation operation, std::optional<Callback> callback = std::nullopt,
+                                                       const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                                                       const CancellationToken& parent_token = CancellationToken()) {
+        return m_executor.try_submit(std::move(operation), std::move(callback), exception_callback, parent_token);
     }
 
-    bool isFinished() const {
-        return m_isFinished.load(std::memory_order_acquire);
+    std::shared_ptr<CancellableOperation<T>> try_start(CancellableAsyncOperation operation, std::optional<Callback> callback = std::nullopt,
+                                                       const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                                                       const CancellationToken& parent_token = CancellationToken()) {
+        return m_executor.try_submit(std::move(operation), std::move(callback), exception_callback, parent_token);
     }
 
-    bool hasCallback() const {
-        return static_cast<bool>(m_callback);
+    // The operation is only handed to the pool once limiter admits it; see
+    // Executor::submit_limited.
+    template<typename Limiter>
+    std::shared_ptr<CancellableOperation<T>> start_limited(Limiter& limiter, AsyncOperation operation,
+                                                           std::optional<Callback> callback = std::nullopt,
+                                                           const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                                                           const CancellationToken& parent_token = CancellationToken()) {
+        return m_executor.submit_limited(limiter, std::move(operation), std::move(callback), exception_callback, parent_token);
     }
 
-    void setPromiseException(std::exception_ptr e) {
-        if (!isFinished()) {
-            m_ResultPromise->set_exception(std::move(e));
-        }
+    template<typename Limiter>
+    std::shared_ptr<CancellableOperation<T>> start_limited(Limiter& limiter, CancellableAsyncOperation operation,
+                                                           std::optional<Callback> callback = std::nullopt,
+                                                           const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                                                           const CancellationToken& parent_token = CancellationToken()) {
+        return m_executor.submit_limited(limiter, std::move(operation), std::move(callback), exception_callback, parent_token);
     }
 
-    std::future<T> getFuture() {
-        return m_ResultPromise->get_future();
+    void shutdown(ShutdownMode mode = ShutdownMode::Drain,
+                  std::chrono::steady_clock::duration timeout = std::chrono::steady_clock::duration::zero()) const {
+        m_executor.shutdown(mode, timeout);
     }
 
-private:
-    void setPromiseValue(const T& value) {
-        if (!isFinished()) {
-            m_ResultPromise->set_value(value);
-        }
-    }
-
-    Operation m_operation;
-    std::optional<Callback> m_callback;
-    std::atomic<bool> m_isCancelled;
-    std::atomic<bool> m_isFinished;
-    std::shared_ptr<std::promise<T>> m_ResultPromise;
-};
-
-template<typename T>
-class AsyncExecutor {
-public:
-    using AsyncOperation = std::function<T()>;
-    using Callback = std::function<void(T)>;
-    using ExceptionCallback = std::function<void(std::string)>;
-
-    AsyncExecutor(ThreadPool& threadPool, CallbackDispatcher& dispatcher)
-        : m_threadPool(threadPool), m_dispatcher(dispatcher) {}
-
-    std::shared_ptr<CancellableOperation<T>> start(AsyncOperation operation, std::optional<Callback> callback = std::nullopt,
-                                                   const std::optional<ExceptionCallback>& exception_callback = std::nullopt) {
-        auto cancellableOp = std::make_shared<CancellableOperation<T>>(std::move(operation), std::move(callback));
-        std::thread::id current_thread_id = std::this_thread::get_id();
-
-        m_threadPool.enqueue([this, cancellableOp, current_thread_id, exception_callback]() mutable {
-            if (cancellableOp->isCancelled()) {
-                return;
-            }
-
-            try {
-                T result = cancellableOp->execute();
-                if (cancellableOp->isCancelled() || !cancellableOp->hasCallback()) {
-                    return;
-                }
-                m_dispatcher.post([cancellableOp, result, exception_callback]() mutable {
-                    bool cancelled = cancellableOp->isCancelled();
-                    bool finished = cancellableOp->isFinished();
-
-                    if (cancelled || finished) {
-                        return;
-                    }
-                    try {
-                        cancellableOp->callback(result);
-                    } catch (const std::exception& e) {
-                        std::ostringstream oss;
-                        oss << "Callback exception: " << e.what() << std::endl;
-                        const std::string error_message = oss.str();
-                        if (exception_callback) {
-                            (*exception_callback)(error_message);
-                        } else {
-                            std::cerr << error_message;
-                        }
-                    }
-                }, current_thread_id);
-            } catch (const std::exception& e) {
-                std::ostringstream oss;
-                oss << "Operation exception: " << e.what() << std::endl;
-                const std::string error_message = oss.str();
-                if (exception_callback) {
-                    (*exception_callback)(error_message);
-                } else {
-                    std::cerr << error_message;
-                }
-                cancellableOp->setPromiseException(std::current_exception());
-            }
-        });
-
-        return cancellableOp;
-    }
-
-    void shutdown() const {
-        m_threadPool.shutdown();
-        m_dispatcher.stop();
+    void wait_idle() const {
+        m_executor.wait_idle();
     }
 
 private:
-    ThreadPool& m_threadPool;
-    CallbackDispatcher& m_dispatcher;
-};
\ No newline at end of file
+    Executor m_executor;
+};
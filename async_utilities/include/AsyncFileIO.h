@@ -0,0 +1,560 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "Executor.h"
+
+namespace detail {
+
+// Minimal io_uring binding over the raw syscalls. Submissions must be
+// serialised by the caller; completions are reaped by a single thread.
+class IoUring {
+public:
+    explicit IoUring(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        m_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (m_fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+        }
+
+        m_sqLength = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cqLength = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap) {
+            m_sqLength = m_cqLength = std::max(m_sqLength, m_cqLength);
+        }
+        m_sqRing = map(m_sqLength, IORING_OFF_SQ_RING);
+        m_cqRing = single_mmap ? m_sqRing : map(m_cqLength, IORING_OFF_CQ_RING);
+        m_sqesLength = params.sq_entries * sizeof(io_uring_sqe);
+        m_sqes = static_cast<io_uring_sqe*>(map(m_sqesLength, IORING_OFF_SQES));
+
+        auto* sq = static_cast<char*>(m_sqRing);
+        m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        m_sqEntries = params.sq_entries;
+        m_cqEntries = params.cq_entries;
+
+        auto* cq = static_cast<char*>(m_cqRing);
+        m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    ~IoUring() {
+        release();
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // The number of completions that can be pending before the kernel has
+    // to drop or buffer them.
+    unsigned completion_capacity() const {
+        return m_cqEntries;
+    }
+
+    // Fills the next submission slot and hands it to the kernel.
+    void submit(const std::function<void(io_uring_sqe&)>& prepare, std::uint64_t user_data) {
+        unsigned tail = *m_sqTail;
+        while (tail - std::atomic_ref<unsigned>(*m_sqHead).load(std::memory_order_acquire) >= m_sqEntries) {
+            enter(0, 0, 0);
+        }
+        unsigned index = tail & m_sqMask;
+        io_uring_sqe& sqe = m_sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        prepare(sqe);
+        sqe.user_data = user_data;
+        m_sqArray[index] = index;
+        std::atomic_ref<unsigned>(*m_sqTail).store(tail + 1, std::memory_order_release);
+
+        unsigned unsubmitted = tail + 1 - std::atomic_ref<unsigned>(*m_sqHead).load(std::memory_order_acquire);
+        enter(unsubmitted, 0, 0);
+    }
+
+    // Blocks until at least one completion is available, then hands every
+    // available completion to handler.
+    template<typename Handler>
+    void wait_completions(Handler&& handler) {
+        enter(0, 1, IORING_ENTER_GETEVENTS);
+        unsigned head = *m_cqHead;
+        unsigned tail = std::atomic_ref<unsigned>(*m_cqTail).load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+            handler(cqe.user_data, cqe.res);
+        }
+        std::atomic_ref<unsigned>(*m_cqHead).store(head, std::memory_order_release);
+    }
+
+private:
+    void* map(size_t length, off_t offset) {
+        void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+        if (ptr == MAP_FAILED) {
+            int error = errno;
+            release();
+            throw std::system_error(error, std::generic_category(), "io_uring mmap");
+        }
+        return ptr;
+    }
+
+    void release() {
+        if (m_sqes) {
+            munmap(m_sqes, m_sqesLength);
+        }
+        if (m_cqRing && m_cqRing != m_sqRing) {
+            munmap(m_cqRing, m_cqLength);
+        }
+        if (m_sqRing) {
+            munmap(m_sqRing, m_sqLength);
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+        m_sqes = nullptr;
+        m_cqRing = m_sqRing = nullptr;
+        m_fd = -1;
+    }
+
+    void enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        while (syscall(__NR_io_uring_enter, m_fd, to_submit, min_complete, flags, nullptr, 0) < 0 &&
+               errno == EINTR) {
+        }
+    }
+
+    int m_fd = -1;
+    void* m_sqRing = nullptr;
+    void* m_cqRing = nullptr;
+    size_t m_sqLength = 0;
+    size_t m_cqLength = 0;
+    size_t m_sqesLength = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    unsigned* m_sqHead = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned m_sqMask = 0;
+    unsigned m_sqEntries = 0;
+    unsigned m_cqEntries = 0;
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    unsigned m_cqMask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+};
+
+} // namespace detail
+
+// Linux only. Asynchronous file operations. With the IoUring backend
+// requests are handed to the kernel and completed by one reaper thread, so
+// thousands of reads can be in flight without occupying pool threads. When
+// io_uring is unavailable the blocking calls run on the executor's thread
+// pool instead.
+class AsyncFileIO {
+public:
+    using Buffer = std::vector<std::byte>;
+    using ExceptionCallback = Executor::ExceptionCallback;
+
+    // The most a single read or write transfers on Linux; read_at and
+    // write_at reject larger requests.
+    static constexpr size_t MaxTransfer = 0x7ffff000;
+
+    enum class Backend { IoUring, ThreadPool };
+
+    explicit AsyncFileIO(const Executor& executor, unsigned queue_depth = 256, Backend preferred = Backend::IoUring)
+        : m_executor(executor), m_backend(Backend::ThreadPool), m_running(true), m_nextId(1), m_inFlight(0) {
+        if (preferred == Backend::IoUring) {
+            try {
+                m_ring = std::make_unique<detail::IoUring>(std::max(queue_depth, 2u));
+                m_backend = Backend::IoUring;
+                m_thread = std::thread([this]() { reap(); });
+            } catch (const std::system_error&) {
+                m_ring.reset();
+            }
+        }
+    }
+
+    ~AsyncFileIO() {
+        stop();
+    }
+
+    AsyncFileIO(const AsyncFileIO&) = delete;
+    AsyncFileIO& operator=(const AsyncFileIO&) = delete;
+
+    Backend backend() const {
+        return m_backend;
+    }
+
+    // Completes with the new file descriptor.
+    Operation<int> open(std::string path, int flags, mode_t mode = 0644,
+                        std::optional<CancellableOperation<int>::Callback> callback = std::nullopt,
+                        const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                        const CancellationToken& parent_token = CancellationToken()) {
+        auto name = std::make_shared<std::string>(std::move(path));
+        return start<int>(
+            [name, flags, mode](auto& sqe) {
+                sqe.opcode = IORING_OP_OPENAT;
+                sqe.fd = AT_FDCWD;
+                sqe.addr = reinterpret_cast<std::uint64_t>(name->c_str());
+                sqe.len = mode;
+                sqe.open_flags = static_cast<std::uint32_t>(flags | O_CLOEXEC);
+            },
+            [name, flags, mode]() -> std::int64_t {
+                int fd = ::open(name->c_str(), flags | O_CLOEXEC, mode);
+                return fd < 0 ? -errno : fd;
+            },
+            [](std::int64_t fd) { return static_cast<int>(fd); },
+            name, std::move(callback), exception_callback, parent_token);
+    }
+
+    // Completes with up to size bytes read at offset; a short buffer means
+    // end of file was reached. An offset of -1 reads from the current file
+    // position, which also works for pipes and sockets.
+    Operation<Buffer> read_at(int fd, size_t size, off_t offset,
+                              std::optional<CancellableOperation<Buffer>::Callback> callback = std::nullopt,
+                              const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                              const CancellationToken& parent_token = CancellationToken()) {
+        check_transfer(size);
+        auto buffer = std::make_shared<Buffer>(size);
+        return start<Buffer>(
+            [fd, buffer, offset](auto& sqe) {
+                sqe.opcode = IORING_OP_READ;
+                sqe.fd = fd;
+                sqe.addr = reinterpret_cast<std::uint64_t>(buffer->data());
+                sqe.len = static_cast<std::uint32_t>(buffer->size());
+                sqe.off = static_cast<std::uint64_t>(offset);
+            },
+            [fd, buffer, offset]() -> std::int64_t {
+                ssize_t bytes = offset < 0 ? ::read(fd, buffer->data(), buffer->size())
+                                           : ::pread(fd, buffer->data(), buffer->size(), offset);
+                return bytes < 0 ? -errno : bytes;
+            },
+            [buffer](std::int64_t bytes) {
+                buffer->resize(static_cast<size_t>(bytes));
+                return std::move(*buffer);
+            },
+            buffer, std::move(callback), exception_callback, parent_token);
+    }
+
+    // Completes with the number of bytes written at offset, which may be
+    // less than data.size() just like pwrite().
+    Operation<size_t> write_at(int fd, Buffer data, off_t offset,
+                               std::optional<CancellableOperation<size_t>::Callback> callback = std::nullopt,
+                               const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                               const CancellationToken& parent_token = CancellationToken()) {
+        check_transfer(data.size());
+        auto buffer = std::make_shared<Buffer>(std::move(data));
+        return start<size_t>(
+            [fd, buffer, offset](auto& sqe) {
+                sqe.opcode = IORING_OP_WRITE;
+                sqe.fd = fd;
+                sqe.addr = reinterpret_cast<std::uint64_t>(buffer->data());
+                sqe.len = static_cast<std::uint32_t>(buffer->size());
+                sqe.off = static_cast<std::uint64_t>(offset);
+            },
+            [fd, buffer, offset]() -> std::int64_t {
+                ssize_t bytes = offset < 0 ? ::write(fd, buffer->data(), buffer->size())
+                                           : ::pwrite(fd, buffer->data(), buffer->size(), offset);
+                return bytes < 0 ? -errno : bytes;
+            },
+            [](std::int64_t bytes) { return static_cast<size_t>(bytes); },
+            buffer, std::move(callback), exception_callback, parent_token);
+    }
+
+    Operation<void> fsync(int fd,
+                          std::optional<CancellableOperation<void>::Callback> callback = std::nullopt,
+                          const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                          const CancellationToken& parent_token = CancellationToken()) {
+        return start<void>(
+            [fd](auto& sqe) {
+                sqe.opcode = IORING_OP_FSYNC;
+                sqe.fd = fd;
+            },
+            [fd]() -> std::int64_t { return ::fsync(fd) < 0 ? -errno : 0; },
+            [](std::int64_t) {},
+            nullptr, std::move(callback), exception_callback, parent_token);
+    }
+
+    // Cancels requests that are still in flight and waits until the kernel
+    // has released their buffers. Thread pool requests are unaffected.
+    //
+    // A request the kernel will not cancel, such as a read blocked in an
+    // io-wq worker, is asked again every few milliseconds. Requests still
+    // running at the timeout are completed as cancelled, and their buffers
+    // are leaked because the kernel may yet write into them.
+    void stop(std::chrono::nanoseconds timeout = std::chrono::seconds(1)) {
+        if (!m_running.exchange(false)) {
+            return;
+        }
+        if (!m_ring) {
+            return;
+        }
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        std::vector<std::function<void()>> cancels;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (auto& [id, request] : m_requests) {
+                cancels.push_back(request.cancel);
+            }
+            wake_locked();
+        }
+        for (auto& cancel : cancels) {
+            cancel();
+        }
+
+        std::vector<Request> abandoned;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (!m_drained.wait_for(lock, CancelRetryInterval, [this]() { return m_requests.empty(); })) {
+                if (std::chrono::steady_clock::now() >= deadline) {
+                    for (auto& [id, request] : m_requests) {
+                        abandoned.push_back(std::move(request));
+                    }
+                    m_requests.clear();
+                    m_backlog.clear();
+                    wake_locked();
+                    break;
+                }
+                for (auto& [id, request] : m_requests) {
+                    if (request.submitted && !request.cancelling) {
+                        cancel_locked(id, request);
+                    }
+                }
+            }
+        }
+        m_thread.join();
+
+        for (auto& request : abandoned) {
+            if (request.submitted) {
+                new std::shared_ptr<const void>(std::move(request.keepalive));
+            }
+            request.complete(-ECANCELED);
+        }
+        m_ring.reset();
+    }
+
+private:
+    // Every submission is counted until its completion is reaped. A request
+    // also holds a slot for its cancel while it is in flight, and two slots
+    // are kept for the wakeups stop() sends, so a full ring can still be
+    // cancelled and the completion queue can never overflow.
+    static constexpr unsigned WakeReserve = 2;
+    static constexpr std::uint64_t WakeTag = ~std::uint64_t(0);
+    static constexpr std::uint64_t CancelBit = std::uint64_t(1) << 63;
+    static constexpr auto CancelRetryInterval = std::chrono::milliseconds(10);
+
+    struct Request {
+        std::function<void(io_uring_sqe&)> prepare;
+        std::function<void(std::int64_t)> complete;
+        std::function<void()> cancel;
+        std::shared_ptr<const void> keepalive;
+        bool submitted = false;
+        bool cancelling = false;
+        CancellationRegistration registration;
+    };
+
+    static void check_transfer(size_t size) {
+        if (size > MaxTransfer) {
+            throw std::invalid_argument("AsyncFileIO: transfer larger than MaxTransfer");
+        }
+    }
+
+    // blocking returns the syscall result or -errno and is used by the
+    // ThreadPool backend; keepalive owns the memory the kernel may touch
+    // until the request completes, even if the operation is reclaimed.
+    template<typename R, typename Prepare, typename Blocking, typename Finish>
+    Operation<R> start(Prepare prepare, Blocking blocking, Finish finish, std::shared_ptr<const void> keepalive,
+                       std::optional<typename CancellableOperation<R>::Callback> callback,
+                       const std::optional<ExceptionCallback>& exception_callback,
+                       const CancellationToken& parent_token) {
+        auto result = [finish](std::int64_t res) -> R {
+            if (res < 0) {
+                throw std::system_error(static_cast<int>(-res), std::generic_category(), "AsyncFileIO");
+            }
+            return finish(res);
+        };
+
+        if (m_ring) {
+            auto res = std::make_shared<std::int64_t>(0);
+            auto op = m_executor.make_operation([res, result]() -> R { return result(*res); },
+                                                std::move(callback), parent_token);
+            enqueue(op, std::move(prepare), res, std::move(keepalive), exception_callback);
+            return op;
+        }
+        if (!m_running) {
+            throw std::runtime_error("AsyncFileIO: stopped");
+        }
+        return m_executor.submit([blocking, result]() -> R { return result(blocking()); },
+                                 std::move(callback), exception_callback, parent_token);
+    }
+
+    template<typename R, typename Prepare>
+    void enqueue(const Operation<R>& op, Prepare prepare, std::shared_ptr<std::int64_t> res,
+                 std::shared_ptr<const void> keepalive, const std::optional<ExceptionCallback>& exception_callback) {
+        Request request;
+        request.prepare = std::move(prepare);
+        request.complete = [executor = m_executor, op, res, exception_callback,
+                            thread_id = m_executor.callback_thread()](std::int64_t value) mutable {
+            *res = value;
+            executor.run(op, exception_callback, thread_id);
+        };
+        request.cancel = [op]() { op->cancel(); };
+        request.keepalive = std::move(keepalive);
+
+        std::uint64_t id;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running) {
+                throw std::runtime_error("AsyncFileIO: stopped");
+            }
+            id = m_nextId++;
+            Request& stored = m_requests.emplace(id, std::move(request)).first->second;
+            // Requests beyond the ring's capacity wait here, so completions
+            // can never overflow the completion queue.
+            if (has_room_locked()) {
+                submit_locked(id, stored);
+            } else {
+                m_backlog.push_back(id);
+            }
+        }
+
+        CancellationRegistration registration(op->getCancellationToken(), [this, id]() { cancel_request(id); });
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_requests.find(id);
+        if (it != m_requests.end()) {
+            std::swap(it->second.registration, registration);
+        }
+    }
+
+    // The helpers below are called with m_mutex held.
+    bool has_room_locked() const {
+        return m_inFlight + 2 + WakeReserve <= m_ring->completion_capacity();
+    }
+
+    void submit_locked(std::uint64_t id, Request& request) {
+        m_ring->submit(request.prepare, id);
+        request.submitted = true;
+        m_inFlight += 2;
+    }
+
+    // Uses the slot the request holds. Once the cancel's completion arrives
+    // another one may be sent; stop() does so for requests the kernel could
+    // not cancel yet.
+    void cancel_locked(std::uint64_t id, Request& request) {
+        request.cancelling = true;
+        m_ring->submit([id](auto& sqe) {
+            sqe.opcode = IORING_OP_ASYNC_CANCEL;
+            sqe.addr = id;
+        }, id | CancelBit);
+    }
+
+    void wake_locked() {
+        m_ring->submit([](auto& sqe) { sqe.opcode = IORING_OP_NOP; }, WakeTag);
+        m_inFlight++;
+    }
+
+    void cancel_request(std::uint64_t id) {
+        Request removed;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_requests.find(id);
+        if (it == m_requests.end()) {
+            return;
+        }
+        if (it->second.submitted) {
+            // The kernel still owns the buffers; the request is released
+            // when its (usually -ECANCELED) completion arrives.
+            if (!it->second.cancelling) {
+                cancel_locked(id, it->second);
+            }
+            return;
+        }
+        for (auto backlog = m_backlog.begin(); backlog != m_backlog.end(); ++backlog) {
+            if (*backlog == id) {
+                m_backlog.erase(backlog);
+                break;
+            }
+        }
+        removed = std::move(it->second);
+        m_requests.erase(it);
+    }
+
+    void reap() {
+        std::vector<std::pair<Request, int>> completed;
+        while (true) {
+            m_ring->wait_completions([this, &completed](std::uint64_t id, int res) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = id == WakeTag ? m_requests.end() : m_requests.find(id & ~CancelBit);
+                if (it == m_requests.end()) {
+                    // A wakeup, or the cancel of a request that has already
+                    // completed, which gives back the request's last slot.
+                    // Requests abandoned by stop() keep theirs.
+                    if (id == WakeTag || (id & CancelBit)) {
+                        m_inFlight--;
+                    }
+                } else if (id & CancelBit) {
+                    // -ENOENT or -EALREADY leave the request running.
+                    it->second.cancelling = false;
+                } else {
+                    m_inFlight -= it->second.cancelling ? 1 : 2;
+                    completed.emplace_back(std::move(it->second), res);
+                    m_requests.erase(it);
+                }
+                while (!m_backlog.empty() && has_room_locked()) {
+                    std::uint64_t next = m_backlog.front();
+                    m_backlog.pop_front();
+                    submit_locked(next, m_requests.at(next));
+                }
+            });
+
+            // Completion runs outside the lock because it may post callbacks,
+            // and destroying a request waits for its cancellation callback.
+            for (auto& [request, res] : completed) {
+                request.complete(res);
+            }
+            completed.clear();
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running && m_requests.empty()) {
+                m_drained.notify_all();
+                break;
+            }
+        }
+    }
+
+    Executor m_executor;
+    Backend m_backend;
+    std::atomic<bool> m_running;
+    std::unique_ptr<detail::IoUring> m_ring;
+    std::unordered_map<std::uint64_t, Request> m_requests;
+    std::deque<std::uint64_t> m_backlog;
+    std::uint64_t m_nextId;
+    unsigned m_inFlight;
+    std::mutex m_mutex;
+    std::condition_variable m_drained;
+    std::thread m_thread;
+};
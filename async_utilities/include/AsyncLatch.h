@@ -0,0 +1,148 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "CancellationToken.h"
+#include "ThreadPool.h"
+#include "WaiterList.h"
+
+// Single-use countdown. Continuations passed to wait() run on the pool once
+// the count reaches zero, or inline if it already has.
+class AsyncLatch {
+public:
+    using Continuation = std::function<void()>;
+
+    AsyncLatch(ThreadPool& threadPool, size_t count) : m_threadPool(threadPool), m_count(count) {}
+
+    AsyncLatch(const AsyncLatch&) = delete;
+    AsyncLatch& operator=(const AsyncLatch&) = delete;
+
+    void count_down(size_t n = 1) {
+        std::vector<detail::Waiter> released;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (n > m_count) {
+                throw std::logic_error("AsyncLatch: count_down below zero");
+            }
+            m_count -= n;
+            if (m_count == 0) {
+                while (std::optional<detail::Waiter> waiter = m_waiters.pop()) {
+                    released.push_back(std::move(*waiter));
+                }
+            }
+        }
+        for (auto& waiter : released) {
+            m_threadPool.post_or_run(std::move(waiter.resume));
+        }
+    }
+
+    bool try_wait() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_count == 0;
+    }
+
+    void wait(Continuation continuation, const CancellationToken& token = CancellationToken()) {
+        if (token.is_cancellation_requested()) {
+            return;
+        }
+        detail::WaiterList::Id id = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_count > 0) {
+                id = m_waiters.push(std::move(continuation));
+            }
+        }
+        if (id == 0) {
+            continuation();
+            return;
+        }
+        m_waiters.watch(m_mutex, id, token);
+    }
+
+private:
+    ThreadPool& m_threadPool;
+    mutable std::mutex m_mutex;
+    size_t m_count;
+    detail::WaiterList m_waiters;
+};
+
+// Reusable barrier for a fixed set of participants. When the last
+// participant of a phase arrives, the optional completion runs on that
+// thread and every continuation of the phase is resumed on the pool.
+class AsyncBarrier {
+public:
+    using Continuation = std::function<void()>;
+
+    AsyncBarrier(ThreadPool& threadPool, size_t participants, Continuation completion = nullptr)
+        : m_threadPool(threadPool), m_participants(participants), m_arrived(0), m_phase(0),
+          m_completion(std::move(completion)) {}
+
+    AsyncBarrier(const AsyncBarrier&) = delete;
+    AsyncBarrier& operator=(const AsyncBarrier&) = delete;
+
+    void arrive_and_wait(Continuation continuation) {
+        std::vector<Continuation> released;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_waiters.push_back(std::move(continuation));
+            m_arrived++;
+            released = complete_phase_locked();
+        }
+        finish_phase(released);
+    }
+
+    // Leaves the barrier for this and all later phases without waiting.
+    void arrive_and_drop() {
+        std::vector<Continuation> released;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_participants == 0) {
+                throw std::logic_error("AsyncBarrier: no participants left");
+            }
+            m_participants--;
+            released = complete_phase_locked();
+        }
+        finish_phase(released);
+    }
+
+    size_t phase() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_phase;
+    }
+
+private:
+    // Called with m_mutex held.
+    std::vector<Continuation> complete_phase_locked() {
+        std::vector<Continuation> released;
+        if (m_arrived == 0 || m_arrived < m_participants) {
+            return released;
+        }
+        released.swap(m_waiters);
+        m_arrived = 0;
+        m_phase++;
+        return released;
+    }
+
+    void finish_phase(std::vector<Continuation>& released) {
+        if (released.empty()) {
+            return;
+        }
+        if (m_completion) {
+            m_completion();
+        }
+        for (auto& continuation : released) {
+            m_threadPool.post_or_run(std::move(continuation));
+        }
+    }
+
+    ThreadPool& m_threadPool;
+    mutable std::mutex m_mutex;
+    size_t m_participants;
+    size_t m_arrived;
+    size_t m_phase;
+    Continuation m_completion;
+    std::vector<Continuation> m_waiters;
+};
@@ -0,0 +1,244 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "CancellationToken.h"
+#include "ThreadPool.h"
+#include "WaiterList.h"
+
+// Mutual exclusion without parking threads. lock() takes a continuation
+// that runs while holding the lock: inline if the lock is free, otherwise
+// on the pool once unlock() hands the lock over. The continuation, or work
+// it starts, must eventually call unlock(). Ownership is not tied to a
+// thread, so unlocking from another task is fine.
+class AsyncMutex {
+public:
+    using Continuation = std::function<void()>;
+
+    explicit AsyncMutex(ThreadPool& threadPool) : m_threadPool(threadPool), m_locked(false) {}
+
+    AsyncMutex(const AsyncMutex&) = delete;
+    AsyncMutex& operator=(const AsyncMutex&) = delete;
+
+    bool try_lock() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_locked) {
+            return false;
+        }
+        m_locked = true;
+        return true;
+    }
+
+    // Waiters acquire in FIFO order. A waiter whose token is cancelled is
+    // dropped without running.
+    void lock(Continuation continuation, const CancellationToken& token = CancellationToken()) {
+        if (token.is_cancellation_requested()) {
+            return;
+        }
+        detail::WaiterList::Id id = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_locked) {
+                id = m_waiters.push(std::move(continuation));
+            } else {
+                m_locked = true;
+            }
+        }
+        if (id == 0) {
+            continuation();
+            return;
+        }
+        m_waiters.watch(m_mutex, id, token);
+    }
+
+    // Hands the lock straight to the next waiter, if any.
+    void unlock() {
+        std::optional<detail::Waiter> next;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            next = m_waiters.pop();
+            if (!next) {
+                m_locked = false;
+            }
+        }
+        if (next) {
+            m_threadPool.post_or_run(std::move(next->resume));
+        }
+    }
+
+    // Runs critical_section holding the lock and releases it afterwards,
+    // even if critical_section throws.
+    void run_locked(Continuation critical_section, const CancellationToken& token = CancellationToken()) {
+        lock([this, critical_section]() {
+            try {
+                critical_section();
+            } catch (...) {
+                unlock();
+                throw;
+            }
+            unlock();
+        }, token);
+    }
+
+    bool is_locked() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_locked;
+    }
+
+private:
+    ThreadPool& m_threadPool;
+    mutable std::mutex m_mutex;
+    bool m_locked;
+    detail::WaiterList m_waiters;
+};
+
+// Reader-writer lock without parking threads. Waiters are served in FIFO
+// order, so a waiting writer holds back readers that arrive after it and
+// cannot be starved.
+class AsyncSharedMutex {
+public:
+    using Continuation = std::function<void()>;
+
+    explicit AsyncSharedMutex(ThreadPool& threadPool) : m_threadPool(threadPool), m_writer(false), m_readers(0) {}
+
+    AsyncSharedMutex(const AsyncSharedMutex&) = delete;
+    AsyncSharedMutex& operator=(const AsyncSharedMutex&) = delete;
+
+    bool try_lock() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_writer || m_readers > 0 || !m_waiters.empty()) {
+            return false;
+        }
+        m_writer = true;
+        return true;
+    }
+
+    bool try_lock_shared() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_writer || !m_waiters.empty()) {
+            return false;
+        }
+        m_readers++;
+        return true;
+    }
+
+    void lock(Continuation continuation, const CancellationToken& token = CancellationToken()) {
+        acquire(std::move(continuation), token, true);
+    }
+
+    void lock_shared(Continuation continuation, const CancellationToken& token = CancellationToken()) {
+        acquire(std::move(continuation), token, false);
+    }
+
+    void unlock() {
+        std::vector<detail::Waiter> granted;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_writer = false;
+            granted = grant_locked();
+        }
+        resume(granted);
+    }
+
+    void unlock_shared() {
+        std::vector<detail::Waiter> granted;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_readers == 0) {
+                granted = grant_locked();
+            }
+        }
+        resume(granted);
+    }
+
+    void run_locked(Continuation critical_section, const CancellationToken& token = CancellationToken()) {
+        lock([this, critical_section]() {
+            try {
+                critical_section();
+            } catch (...) {
+                unlock();
+                throw;
+            }
+            unlock();
+        }, token);
+    }
+
+    void run_shared(Continuation critical_section, const CancellationToken& token = CancellationToken()) {
+        lock_shared([this, critical_section]() {
+            try {
+                critical_section();
+            } catch (...) {
+                unlock_shared();
+                throw;
+            }
+            unlock_shared();
+        }, token);
+    }
+
+private:
+    void acquire(Continuation continuation, const CancellationToken& token, bool exclusive) {
+        if (token.is_cancellation_requested()) {
+            return;
+        }
+        detail::WaiterList::Id id = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            bool available = !m_writer && m_waiters.empty() && (!exclusive || m_readers == 0);
+            if (!available) {
+                id = m_waiters.push(std::move(continuation), exclusive);
+            } else if (exclusive) {
+                m_writer = true;
+            } else {
+                m_readers++;
+            }
+        }
+        if (id == 0) {
+            continuation();
+            return;
+        }
+        // A cancelled writer may have been holding back readers behind it.
+        m_waiters.watch(m_mutex, id, token, [this]() {
+            std::vector<detail::Waiter> granted;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                granted = grant_locked();
+            }
+            resume(granted);
+        });
+    }
+
+    // Called with m_mutex held. Admits either the next writer or the run of
+    // readers at the front of the queue.
+    std::vector<detail::Waiter> grant_locked() {
+        std::vector<detail::Waiter> granted;
+        while (const detail::Waiter* front = m_waiters.front()) {
+            if (m_writer) {
+                break;
+            }
+            if (front->exclusive) {
+                if (m_readers == 0) {
+                    m_writer = true;
+                    granted.push_back(std::move(*m_waiters.pop()));
+                }
+                break;
+            }
+            m_readers++;
+            granted.push_back(std::move(*m_waiters.pop()));
+        }
+        return granted;
+    }
+
+    void resume(std::vector<detail::Waiter>& granted) {
+        for (auto& waiter : granted) {
+            m_threadPool.post_or_run(std::move(waiter.resume));
+        }
+    }
+
+    ThreadPool& m_threadPool;
+    std::mutex m_mutex;
+    bool m_writer;
+    size_t m_readers;
+    detail::WaiterList m_waiters;
+};
@@ -0,0 +1,115 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <optional>
+
+#include "CancellationToken.h"
+#include "WaiterList.h"
+
+// Counting semaphore that never blocks a thread. acquire() takes a
+// continuation that runs once a permit is available: inline if one is free
+// right away, otherwise on the thread whose release() hands the permit on.
+// Continuations should therefore be short, e.g. scheduling work on a pool.
+class AsyncSemaphore {
+public:
+    using Continuation = std::function<void()>;
+
+    explicit AsyncSemaphore(size_t permits) : m_permits(permits) {}
+
+    AsyncSemaphore(const AsyncSemaphore&) = delete;
+    AsyncSemaphore& operator=(const AsyncSemaphore&) = delete;
+
+    bool try_acquire() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_permits == 0 || !m_waiters.empty()) {
+            return false;
+        }
+        m_permits--;
+        return true;
+    }
+
+    // Waiters are served in FIFO order. If token is cancelled first, the
+    // continuation is dropped without running and no permit is consumed.
+    void acquire(Continuation continuation, const CancellationToken& token = CancellationToken()) {
+        if (token.is_cancellation_requested()) {
+            return;
+        }
+        detail::WaiterList::Id id;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_permits > 0 && m_waiters.empty()) {
+                m_permits--;
+                id = 0;
+            } else {
+                id = m_waiters.push(std::move(continuation));
+            }
+        }
+        if (id == 0) {
+            continuation();
+            return;
+        }
+        m_waiters.watch(m_mutex, id, token);
+    }
+
+    // A continuation that releases again, e.g. for an operation its pool
+    // refused, only adds to the permits being handed on here, so a long line
+    // of waiters is resumed one after another rather than recursively.
+    void release(size_t count = 1) {
+        for (Releasing* frame = releasing(); frame; frame = frame->outer) {
+            if (frame->semaphore == this) {
+                frame->count += count;
+                return;
+            }
+        }
+        Releasing frame(this, count);
+        while (frame.count > 0) {
+            std::optional<detail::Waiter> waiter;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                waiter = m_waiters.pop();
+                if (!waiter) {
+                    m_permits += frame.count;
+                    break;
+                }
+                frame.count--;
+            }
+            waiter->resume();
+        }
+    }
+
+    size_t available() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_permits;
+    }
+
+    size_t waiting() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_waiters.size();
+    }
+
+private:
+    // The release() calls resuming waiters on this thread, innermost first.
+    struct Releasing {
+        Releasing(AsyncSemaphore* semaphore, size_t count)
+            : semaphore(semaphore), count(count), outer(releasing()) {
+            releasing() = this;
+        }
+
+        ~Releasing() {
+            releasing() = outer;
+        }
+
+        AsyncSemaphore* semaphore;
+        size_t count;
+        Releasing* outer;
+    };
+
+    static Releasing*& releasing() {
+        static thread_local Releasing* frame = nullptr;
+        return frame;
+    }
+
+    mutable std::mutex m_mutex;
+    size_t m_permits;
+    detail::WaiterList m_waiters;
+};
@@ -4,8 +4,17 @@
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <limits>
+#include <stdexcept>
+#include <atomic>
+#include <cstdint>
 #include "LockFreeQueue.h"
 
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 struct CallbackInfo {
     std::function<void()> task;
     std::thread::id thread_id;
@@ -16,13 +25,47 @@ struct CallbackInfo {
 
 class CallbackDispatcher {
 public:
-    CallbackDispatcher() : m_stopped(false) {}
+    // EventFd makes native_handle() readable once callbacks are posted, so an
+    // owner thread can wait for them in its own epoll/poll loop. It is meant
+    // for dispatchers drained by a single owner loop: execute_pending() clears
+    // it, and callbacks bound to other threads do not make it readable again.
+    enum class NotificationMode { None, EventFd };
+
+    explicit CallbackDispatcher(NotificationMode mode = NotificationMode::None)
+        : m_pending(0), m_signalled(false), m_eventFd(-1), m_stopped(false) {
+        if (mode == NotificationMode::EventFd) {
+#ifdef __linux__
+            m_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (m_eventFd < 0) {
+                throw std::runtime_error("CallbackDispatcher: eventfd creation failed");
+            }
+#else
+            throw std::runtime_error("CallbackDispatcher: eventfd notification is not supported on this platform");
+#endif
+        }
+    }
+
+    ~CallbackDispatcher() {
+#ifdef __linux__
+        if (m_eventFd >= 0) {
+            close(m_eventFd);
+        }
+#endif
+    }
+
+    CallbackDispatcher(const CallbackDispatcher&) = delete;
+    CallbackDispatcher& operator=(const CallbackDispatcher&) = delete;
 
     void post(std::function<void()> task, std::thread::id thread_id = std::thread::id()) {
+        // Counted before the task becomes visible, so a consumer can never
+        // decrement past zero.
+        m_pending.fetch_add(1, std::memory_order_acq_rel);
         {
             std::lock_guard<std::mutex> lock(m_mutex);
             m_tasks.enqueue(CallbackInfo(std::move(task), thread_id));
         }
+        // Only the first post since the last drain writes the eventfd.
+        signal();
         m_condition.notify_one();
     }
 
@@ -30,34 +73,51 @@ public:
         std::thread::id current_thread_id = std::this_thread::get_id();
         std::queue<CallbackInfo> tasks_to_execute;
         bool tasks_executed = false;
+        bool tasks_left = false;
 
+        // Posts from here on signal again, and their tasks are either
+        // collected below or wake the owner for the next drain.
+        clear_signal();
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            while (!m_tasks.is_empty() && tasks_to_execute.size() < max_tasks) {
+            // Tasks for other threads are re-enqueued, so only look at the
+            // ones that were queued when we started.
+            size_t queued = m_pending.load(std::memory_order_acquire);
+            size_t examined = 0;
+            for (; examined < queued && tasks_to_execute.size() < max_tasks; ++examined) {
                 auto task = m_tasks.dequeue();
-                if (task) {
-                    if (task->thread_id == std::thread::id() ||
-                        task->thread_id == current_thread_id)
-                    {
-                        tasks_to_execute.push(std::move(*task));
-                    } else {
-                        m_tasks.enqueue(*task);
-                    }
+                if (!task) {
+                    break;
+                }
+                if (task->thread_id == std::thread::id() ||
+                    task->thread_id == current_thread_id)
+                {
+                    tasks_to_execute.push(std::move(*task));
+                } else {
+                    m_tasks.enqueue(std::move(*task));
                 }
             }
+            tasks_left = examined < queued && tasks_to_execute.size() == max_tasks;
         }
 
+        // The collected tasks have left the queue, so they stop counting as
+        // pending even if one of them throws and the rest are dropped.
+        ConsumedTasks consumed{*this, tasks_to_execute.size(), tasks_left};
         while (!tasks_to_execute.empty()) {
             tasks_to_execute.front().task();
             tasks_to_execute.pop();
             tasks_executed = true;
         }
-
         return tasks_executed;
     }
 
     bool has_pending_tasks() const {
-        return !m_tasks.is_empty();
+        return m_pending.load(std::memory_order_acquire) != 0;
+    }
+
+    // The eventfd to register for EPOLLIN in EventFd mode, -1 otherwise.
+    int native_handle() const {
+        return m_eventFd;
     }
 
     void stop() {
@@ -73,8 +133,46 @@ public:
     }
 
 private:
+    struct ConsumedTasks {
+        CallbackDispatcher& dispatcher;
+        size_t count;
+        // Set when max_tasks stopped the drain before it saw every task.
+        bool tasks_left;
+
+        ~ConsumedTasks() {
+            dispatcher.m_pending.fetch_sub(count, std::memory_order_acq_rel);
+            if (tasks_left) {
+                dispatcher.signal();
+            }
+        }
+    };
+
+    void signal() {
+#ifdef __linux__
+        if (m_eventFd >= 0 && !m_signalled.exchange(true, std::memory_order_acq_rel)) {
+            std::uint64_t one = 1;
+            ssize_t written = write(m_eventFd, &one, sizeof(one));
+            (void)written;
+        }
+#endif
+    }
+
+    void clear_signal() {
+#ifdef __linux__
+        if (m_eventFd >= 0) {
+            std::uint64_t value;
+            ssize_t bytes = read(m_eventFd, &value, sizeof(value));
+            (void)bytes;
+            m_signalled.store(false, std::memory_order_seq_cst);
+        }
+#endif
+    }
+
     LockFreeQueue<CallbackInfo> m_tasks;
+    std::atomic<size_t> m_pending;
+    std::atomic<bool> m_signalled;
+    int m_eventFd;
     std::mutex m_mutex;
     std::condition_variable m_condition;
     bool m_stopped;
-};
\ No newline at end of file
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include "CancellationToken.h"
+
+namespace detail {
+
+template<typename T>
+struct OperationSignature {
+    using Operation = std::function<T(const CancellationToken&)>;
+    using Callback = std::function<void(const T&)>;
+};
+
+template<>
+struct OperationSignature<void> {
+    using Operation = std::function<void(const CancellationToken&)>;
+    using Callback = std::function<void()>;
+};
+
+} // namespace detail
+
+// The result is moved once into a shared state that backs both the future
+// and the callback, so T may be void or move-only.
+template<typename T>
+class CancellableOperation {
+public:
+    using Operation = typename detail::OperationSignature<T>::Operation;
+    using Callback = typename detail::OperationSignature<T>::Callback;
+
+    explicit CancellableOperation(Operation op, std::optional<Callback> cb,
+                                  const CancellationToken& parent_token = CancellationToken())
+        : m_operation(std::move(op)), m_callback(std::move(cb)), m_cancellation(parent_token),
+          m_state(State::Pending), m_isFinished(false), m_hasResult(false),
+          m_ResultFuture(m_ResultPromise.get_future().share()) {
+        // Registered last so that a parent that is already cancelled finds
+        // the operation fully constructed.
+        m_cancelRegistration = CancellationRegistration(m_cancellation.get_token(), [this]() {
+            reclaimIfPending();
+        });
+    }
+
+    void execute() {
+        State expected = State::Pending;
+        if (!m_state.compare_exchange_strong(expected, State::Running, std::memory_order_acq_rel)) {
+            throw OperationCancelledException();
+        }
+        Operation operation = std::move(m_operation);
+        if constexpr (std::is_void_v<T>) {
+            operation(m_cancellation.get_token());
+            m_state.store(State::Completed, std::memory_order_release);
+            setPromiseValue();
+        } else {
+            T result = operation(m_cancellation.get_token());
+            m_state.store(State::Completed, std::memory_order_release);
+            setPromiseValue(std::move(result));
+        }
+    }
+
+    // Invokes the callback with the stored result. Only valid once execute()
+    // has completed.
+    void callback() {
+        if (!isCancelled() && !m_isFinished.exchange(true)) {
+            if(m_callback) {
+                if constexpr (std::is_void_v<T>) {
+                    (*m_callback)();
+                } else {
+                    (*m_callback)(m_ResultFuture.get());
+                }
+            }
+        }
+    }
+
+    // Requests cancellation. An operation that has not started yet is
+    // reclaimed immediately and its future fails with
+    // OperationCancelledException; a running operation observes the request
+    // through its CancellationToken.
+    void cancel() {
+        m_cancellation.request_cancellation();
+    }
+
+    bool isCancelled() const {
+        return m_cancellation.is_cancellation_requested();
+    }
+
+    bool isFinished() const {
+        return m_isFinished.load(std::memory_order_acquire);
+    }
+
+    bool hasCallback() const {
+        return static_cast<bool>(m_callback);
+    }
+
+    CancellationToken getCancellationToken() const {
+        return m_cancellation.get_token();
+    }
+
+    void setPromiseException(std::exception_ptr e) {
+        if (!m_hasResult.exchange(true, std::memory_order_acq_rel)) {
+            m_ResultPromise.set_exception(std::move(e));
+        }
+    }
+
+    std::shared_future<T> getFuture() const {
+        return m_ResultFuture;
+    }
+
+private:
+    enum class State { Pending, Running, Completed, Cancelled };
+
+    template<typename... Value>
+    void setPromiseValue(Value&&... value) {
+        if (!m_hasResult.exchange(true, std::memory_order_acq_rel)) {
+            m_ResultPromise.set_value(std::forward<Value>(value)...);
+        }
+    }
+
+    void reclaimIfPending() {
+        State expected = State::Pending;
+        if (m_state.compare_exchange_strong(expected, State::Cancelled, std::memory_order_acq_rel)) {
+            m_operation = nullptr;
+            m_callback.reset();
+            setPromiseException(std::make_exception_ptr(OperationCancelledException()));
+        }
+    }
+
+    Operation m_operation;
+    std::optional<Callback> m_callback;
+    CancellationSource m_cancellation;
+    std::atomic<State> m_state;
+    std::atomic<bool> m_isFinished;
+    std::atomic<bool> m_hasResult;
+    std::promise<T> m_ResultPromise;
+    std::shared_future<T> m_ResultFuture;
+    CancellationRegistration m_cancelRegistration;
+};
+
+template<typename T>
+using Operation = std::shared_ptr<CancellableOperation<T>>;
@@ -0,0 +1,220 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class OperationCancelledException : public std::runtime_error {
+public:
+    OperationCancelledException() : std::runtime_error("Operation cancelled") {}
+};
+
+namespace detail {
+
+class CancellationState {
+public:
+    using Callback = std::function<void()>;
+    using CallbackId = std::uint64_t;
+
+    CancellationState() : m_cancelled(false), m_callbacksRunning(false), m_nextId(0), m_parentLinkId(0) {}
+
+    ~CancellationState() {
+        if (m_parent) {
+            m_parent->deregister_callback(m_parentLinkId);
+        }
+    }
+
+    bool is_cancellation_requested() const {
+        return m_cancelled.load(std::memory_order_acquire);
+    }
+
+    bool request_cancellation() {
+        if (m_cancelled.exchange(true, std::memory_order_acq_rel)) {
+            return false;
+        }
+
+        std::unordered_map<CallbackId, Callback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            callbacks.swap(m_callbacks);
+            m_callbacksRunning = true;
+            m_invokingThread = std::this_thread::get_id();
+        }
+
+        for (auto& [id, callback] : callbacks) {
+            callback();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_callbacksRunning = false;
+            m_invokingThread = std::thread::id();
+        }
+        m_condition.notify_all();
+        return true;
+    }
+
+    // Returns 0 if cancellation was already requested, in which case the
+    // callback has been invoked synchronously on the calling thread.
+    CallbackId register_callback(Callback callback) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_cancelled.load(std::memory_order_acquire)) {
+                CallbackId id = ++m_nextId;
+                m_callbacks.emplace(id, std::move(callback));
+                return id;
+            }
+        }
+        callback();
+        return 0;
+    }
+
+    // Blocks until the callback has finished if it is currently running on
+    // another thread, so the caller may safely destroy what it references.
+    void deregister_callback(CallbackId id) {
+        if (id == 0) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_callbacks.erase(id) > 0) {
+            return;
+        }
+        if (m_invokingThread != std::this_thread::get_id()) {
+            m_condition.wait(lock, [this] { return !m_callbacksRunning; });
+        }
+    }
+
+    void link_to_parent(const std::shared_ptr<CancellationState>& parent,
+                        const std::shared_ptr<CancellationState>& self) {
+        std::weak_ptr<CancellationState> weak_self = self;
+        m_parent = parent;
+        m_parentLinkId = parent->register_callback([weak_self]() {
+            if (auto state = weak_self.lock()) {
+                state->request_cancellation();
+            }
+        });
+    }
+
+private:
+    std::atomic<bool> m_cancelled;
+    bool m_callbacksRunning;
+    std::thread::id m_invokingThread;
+    CallbackId m_nextId;
+    std::unordered_map<CallbackId, Callback> m_callbacks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+
+    std::shared_ptr<CancellationState> m_parent;
+    CallbackId m_parentLinkId;
+};
+
+} // namespace detail
+
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    bool is_cancellation_requested() const {
+        return m_state && m_state->is_cancellation_requested();
+    }
+
+    bool can_be_cancelled() const {
+        return static_cast<bool>(m_state);
+    }
+
+    void throw_if_cancellation_requested() const {
+        if (is_cancellation_requested()) {
+            throw OperationCancelledException();
+        }
+    }
+
+private:
+    friend class CancellationSource;
+    friend class CancellationRegistration;
+
+    explicit CancellationToken(std::shared_ptr<detail::CancellationState> state)
+        : m_state(std::move(state)) {}
+
+    std::shared_ptr<detail::CancellationState> m_state;
+};
+
+class CancellationSource {
+public:
+    CancellationSource() : m_state(std::make_shared<detail::CancellationState>()) {}
+
+    // Creates a source that is cancelled together with the parent token.
+    explicit CancellationSource(const CancellationToken& parent) : CancellationSource() {
+        if (parent.m_state) {
+            m_state->link_to_parent(parent.m_state, m_state);
+        }
+    }
+
+    CancellationToken get_token() const {
+        return CancellationToken(m_state);
+    }
+
+    bool request_cancellation() const {
+        return m_state->request_cancellation();
+    }
+
+    bool is_cancellation_requested() const {
+        return m_state->is_cancellation_requested();
+    }
+
+private:
+    std::shared_ptr<detail::CancellationState> m_state;
+};
+
+// Invokes the callback once cancellation is requested on the token. The
+// callback is deregistered when the registration is destroyed.
+class CancellationRegistration {
+public:
+    CancellationRegistration() : m_id(0) {}
+
+    CancellationRegistration(const CancellationToken& token, std::function<void()> callback)
+        : m_state(token.m_state), m_id(0) {
+        if (m_state) {
+            m_id = m_state->register_callback(std::move(callback));
+        }
+    }
+
+    CancellationRegistration(CancellationRegistration&& other) noexcept
+        : m_state(std::move(other.m_state)), m_id(other.m_id) {
+        other.m_id = 0;
+    }
+
+    CancellationRegistration& operator=(CancellationRegistration&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_state = std::move(other.m_state);
+            m_id = other.m_id;
+            other.m_id = 0;
+        }
+        return *this;
+    }
+
+    CancellationRegistration(const CancellationRegistration&) = delete;
+    CancellationRegistration& operator=(const CancellationRegistration&) = delete;
+
+    ~CancellationRegistration() {
+        reset();
+    }
+
+    void reset() {
+        if (m_state) {
+            m_state->deregister_callback(m_id);
+            m_state.reset();
+        }
+        m_id = 0;
+    }
+
+private:
+    std::shared_ptr<detail::CancellationState> m_state;
+    detail::CancellationState::CallbackId m_id;
+};
@@ -0,0 +1,232 @@
+#pragma once
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "HazardPointer.h"
+
+// Compile-time layout options for LockFreeQueue, LockFreeStack and
+// LockFreeList.
+enum class NodeStorage {
+    Indirect,  // payload in its own shared_ptr<T> allocation
+    Inline,    // payload inside the node; trivially copyable types only
+};
+
+enum class MemoryOrdering {
+    AcquireRelease,
+    // Every publishing and consuming access is seq_cst. Slower; useful to
+    // rule out ordering bugs.
+    SequentiallyConsistent,
+};
+
+// pad_ends puts each end pointer (head, tail, top) on its own cache line so
+// producers and consumers do not false-share. capacity_hint nodes are
+// allocated when the container is built, and retired nodes refill them, so
+// pushes skip the allocator while the container stays within the hint.
+template<NodeStorage Storage = NodeStorage::Indirect, bool PadEnds = false, size_t CapacityHint = 0,
+         MemoryOrdering Ordering = MemoryOrdering::AcquireRelease>
+struct ContainerPolicy {
+    static constexpr NodeStorage storage = Storage;
+    static constexpr bool pad_ends = PadEnds;
+    static constexpr size_t capacity_hint = CapacityHint;
+    static constexpr MemoryOrdering ordering = Ordering;
+};
+
+using DefaultContainerPolicy = ContainerPolicy<>;
+
+// For queues of ints, pointers and other small trivially copyable messages.
+using MessageContainerPolicy = ContainerPolicy<NodeStorage::Inline, true>;
+
+template<typename P>
+concept ContainerPolicyType = requires {
+    { P::storage } -> std::convertible_to<NodeStorage>;
+    { P::pad_ends } -> std::convertible_to<bool>;
+    { P::capacity_hint } -> std::convertible_to<size_t>;
+    { P::ordering } -> std::convertible_to<MemoryOrdering>;
+};
+
+template<typename P, typename T>
+concept ContainerPolicyFor = ContainerPolicyType<P> &&
+    (P::storage == NodeStorage::Indirect || std::is_trivially_copyable_v<T>);
+
+namespace detail {
+
+inline constexpr size_t CacheLineSize = 64;
+
+template<typename Policy>
+struct MemoryOrders {
+    static constexpr bool seq_cst = Policy::ordering == MemoryOrdering::SequentiallyConsistent;
+    // Making a node, or the payload written before it, visible.
+    static constexpr std::memory_order publish = seq_cst ? std::memory_order_seq_cst : std::memory_order_release;
+    // Reading a pointer whose target is then dereferenced.
+    static constexpr std::memory_order consume = seq_cst ? std::memory_order_seq_cst : std::memory_order_acquire;
+    // Read-modify-writes that do both.
+    static constexpr std::memory_order exchange = seq_cst ? std::memory_order_seq_cst : std::memory_order_acq_rel;
+};
+
+// An end pointer of a container, optionally alone on its cache line.
+template<typename T, bool Padded>
+struct alignas(Padded ? CacheLineSize : alignof(std::atomic<T>)) AtomicEnd : std::atomic<T> {
+    using std::atomic<T>::atomic;
+    using std::atomic<T>::operator=;
+};
+
+template<typename T, NodeStorage Storage>
+class NodeValue {
+public:
+    NodeValue() = default;
+
+    template<typename U>
+    void emplace(U&& value) {
+        if constexpr (Storage == NodeStorage::Inline) {
+            // Trivially copyable, so the value never needs destroying.
+            std::construct_at(reinterpret_cast<T*>(m_slot.bytes), std::forward<U>(value));
+            m_slot.engaged = true;
+        } else {
+            m_slot = std::make_shared<T>(std::forward<U>(value));
+        }
+    }
+
+    bool has_value() const {
+        if constexpr (Storage == NodeStorage::Inline) {
+            return m_slot.engaged;
+        } else {
+            return m_slot != nullptr;
+        }
+    }
+
+    const T& get() const {
+        if constexpr (Storage == NodeStorage::Inline) {
+            return *std::launder(reinterpret_cast<const T*>(m_slot.bytes));
+        } else {
+            return *m_slot;
+        }
+    }
+
+    // Only for the thread that has exclusive use of the node.
+    T take() {
+        if constexpr (Storage == NodeStorage::Inline) {
+            return get();
+        } else {
+            std::shared_ptr<T> data = std::move(m_slot);
+            return std::move(*data);
+        }
+    }
+
+private:
+    struct InlineSlot {
+        alignas(T) std::byte bytes[sizeof(T)];
+        bool engaged = false;
+    };
+
+    std::conditional_t<Storage == NodeStorage::Inline, InlineSlot, std::shared_ptr<T>> m_slot;
+};
+
+// Nodes allocated up front for a container's capacity hint. Retired nodes
+// come back here once no hazard pointer refers to them, while the reserve
+// holds fewer than Count; the rest are deleted. A node cannot come back
+// while take() protects it, so take() is free of ABA.
+template<typename Node, size_t Count>
+class NodeReserve {
+public:
+    NodeReserve() : m_free(new FreeList()) {
+        for (size_t i = 0; i < Count; ++i) {
+            m_free->push(new Node());
+        }
+        m_free->size.store(Count, std::memory_order_relaxed);
+    }
+
+    ~NodeReserve() {
+        FreeList::release(m_free);
+    }
+
+    NodeReserve(const NodeReserve&) = delete;
+    NodeReserve& operator=(const NodeReserve&) = delete;
+
+    // Returns nullptr while the reserve is empty.
+    Node* take() {
+        if (m_free->top.load(std::memory_order_relaxed) == nullptr) {
+            return nullptr;
+        }
+        HazardPointer hp_top;
+        while (true) {
+            Node* top = hp_top.protect(m_free->top);
+            if (top == nullptr) {
+                return nullptr;
+            }
+            Node* next = top->next.load(std::memory_order_relaxed);
+            if (m_free->top.compare_exchange_weak(top, next, std::memory_order_acquire, std::memory_order_relaxed)) {
+                m_free->size.fetch_sub(1, std::memory_order_relaxed);
+                top->next.store(nullptr, std::memory_order_relaxed);
+                return top;
+            }
+        }
+    }
+
+    // Replaces retire_hazard_pointer() for nodes the container unlinked.
+    void retire(Node* node) const {
+        m_free->refs.fetch_add(1, std::memory_order_relaxed);
+        retire_hazard_pointer<&FreeList::recycle>(node, m_free);
+    }
+
+private:
+    // Retired nodes hold a reference, since whichever thread scans them may
+    // recycle them after the container is gone.
+    struct FreeList {
+        std::atomic<Node*> top{nullptr};
+        std::atomic<size_t> size{0};
+        std::atomic<size_t> refs{1};
+
+        void push(Node* node) {
+            Node* old_top = top.load(std::memory_order_relaxed);
+            do {
+                node->next.store(old_top, std::memory_order_relaxed);
+            } while (!top.compare_exchange_weak(old_top, node, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        static void recycle(Node* node, FreeList* list) {
+            if (list->size.fetch_add(1, std::memory_order_relaxed) < Count) {
+                std::destroy_at(node);
+                std::construct_at(node);
+                list->push(node);
+            } else {
+                list->size.fetch_sub(1, std::memory_order_relaxed);
+                delete node;
+            }
+            release(list);
+        }
+
+        static void release(FreeList* list) {
+            if (list->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+            Node* node = list->top.load(std::memory_order_relaxed);
+            while (node) {
+                Node* next = node->next.load(std::memory_order_relaxed);
+                delete node;
+                node = next;
+            }
+            delete list;
+        }
+    };
+
+    FreeList* m_free;
+};
+
+template<typename Node>
+class NodeReserve<Node, 0> {
+public:
+    Node* take() {
+        return nullptr;
+    }
+
+    void retire(Node* node) const {
+        retire_hazard_pointer(node);
+    }
+};
+
+} // namespace detail
@@ -0,0 +1,325 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "Executor.h"
+
+// Linux only. A single thread waits for readiness on registered file
+// descriptors and completes Executor operations when the fd can make
+// progress, so blocked reads and writes do not occupy pool threads.
+// Registered fds are switched to non-blocking mode. Each fd may have one
+// pending read and one pending write at a time.
+class EpollReactor {
+public:
+    using Buffer = std::vector<std::byte>;
+    using ExceptionCallback = Executor::ExceptionCallback;
+
+    explicit EpollReactor(const Executor& executor)
+        : m_executor(executor), m_epollFd(epoll_create1(EPOLL_CLOEXEC)),
+          m_wakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), m_running(true) {
+        if (m_epollFd < 0 || m_wakeFd < 0) {
+            close_fds();
+            throw std::system_error(errno, std::generic_category(), "EpollReactor: setup failed");
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = m_wakeFd;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event);
+        m_thread = std::thread([this]() { loop(); });
+    }
+
+    ~EpollReactor() {
+        stop();
+        close_fds();
+    }
+
+    EpollReactor(const EpollReactor&) = delete;
+    EpollReactor& operator=(const EpollReactor&) = delete;
+
+    // Completes with up to max_bytes once fd is readable; an empty buffer
+    // means end of file.
+    Operation<Buffer> async_read(int fd, size_t max_bytes,
+                                 std::optional<CancellableOperation<Buffer>::Callback> callback = std::nullopt,
+                                 const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                                 const CancellationToken& parent_token = CancellationToken()) {
+        auto result = std::make_shared<std::optional<Buffer>>();
+        auto error = std::make_shared<int>(0);
+        auto op = m_executor.make_operation([result, error]() -> Buffer {
+            if (*error != 0) {
+                throw std::system_error(*error, std::generic_category(), "EpollReactor: read failed");
+            }
+            return std::move(**result);
+        }, std::move(callback), parent_token);
+
+        watch(fd, false, op, exception_callback, [fd, max_bytes, result, error]() {
+            Buffer buffer(max_bytes);
+            ssize_t bytes = ::read(fd, buffer.data(), buffer.size());
+            if (bytes < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                    return false;
+                }
+                *error = errno;
+                return true;
+            }
+            buffer.resize(static_cast<size_t>(bytes));
+            *result = std::move(buffer);
+            return true;
+        });
+        return op;
+    }
+
+    // Completes with the number of bytes written once all of data has been
+    // written to fd.
+    Operation<size_t> async_write(int fd, Buffer data,
+                                  std::optional<CancellableOperation<size_t>::Callback> callback = std::nullopt,
+                                  const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                                  const CancellationToken& parent_token = CancellationToken()) {
+        auto buffer = std::make_shared<Buffer>(std::move(data));
+        auto written = std::make_shared<size_t>(0);
+        auto error = std::make_shared<int>(0);
+        auto op = m_executor.make_operation([written, error]() -> size_t {
+            if (*error != 0) {
+                throw std::system_error(*error, std::generic_category(), "EpollReactor: write failed");
+            }
+            return *written;
+        }, std::move(callback), parent_token);
+
+        watch(fd, true, op, exception_callback, [fd, buffer, written, error]() {
+            while (*written < buffer->size()) {
+                ssize_t bytes = ::write(fd, buffer->data() + *written, buffer->size() - *written);
+                if (bytes < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        return false;
+                    }
+                    *error = errno;
+                    return true;
+                }
+                *written += static_cast<size_t>(bytes);
+            }
+            return true;
+        });
+        return op;
+    }
+
+    // Stops the reactor thread and cancels every operation still waiting.
+    void stop() {
+        if (!m_running.exchange(false)) {
+            return;
+        }
+        wake();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+
+        std::unordered_map<int, FdState> fds;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            fds.swap(m_fds);
+        }
+        for (auto& [fd, state] : fds) {
+            for (Waiter* waiter : {&state.reader, &state.writer}) {
+                if (*waiter) {
+                    waiter->cancel();
+                }
+            }
+        }
+    }
+
+private:
+    struct Waiter {
+        const void* id = nullptr;
+        // Returns true once the operation can complete.
+        std::function<bool()> attempt;
+        std::function<void()> complete;
+        std::function<void()> cancel;
+        CancellationRegistration registration;
+
+        explicit operator bool() const {
+            return id != nullptr;
+        }
+    };
+
+    struct FdState {
+        Waiter reader;
+        Waiter writer;
+        bool registered = false;
+    };
+
+    // Waiters own a CancellationRegistration whose callback takes m_mutex, so
+    // they are always destroyed after the lock has been released.
+    template<typename R>
+    void watch(int fd, bool for_write, const Operation<R>& op,
+               const std::optional<ExceptionCallback>& exception_callback, std::function<bool()> attempt) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        if (flags >= 0 && !(flags & O_NONBLOCK)) {
+            fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        }
+
+        const void* id = op.get();
+        Waiter waiter;
+        waiter.id = id;
+        waiter.attempt = std::move(attempt);
+        waiter.complete = [executor = m_executor, op, exception_callback,
+                           thread_id = m_executor.callback_thread()]() mutable {
+            executor.run(op, exception_callback, thread_id);
+        };
+        waiter.cancel = [op]() { op->cancel(); };
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running) {
+                throw std::runtime_error("EpollReactor: reactor is stopped");
+            }
+            FdState& state = m_fds[fd];
+            Waiter& slot = for_write ? state.writer : state.reader;
+            if (slot) {
+                throw std::logic_error("EpollReactor: an operation of this kind is already pending on the fd");
+            }
+            slot = std::move(waiter);
+            update_interest(fd, state);
+        }
+
+        // Cancelled operations leave the interest set right away instead of
+        // waiting for the fd to become ready. The callback may run right
+        // here if the parent token is already cancelled.
+        CancellationRegistration registration(op->getCancellationToken(), [this, fd, for_write, id]() {
+            Waiter removed;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_fds.find(fd);
+            if (it == m_fds.end()) {
+                return;
+            }
+            Waiter& slot = for_write ? it->second.writer : it->second.reader;
+            if (slot.id != id) {
+                return;
+            }
+            removed = std::move(slot);
+            slot = Waiter();
+            update_interest(fd, it->second);
+        });
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_fds.find(fd);
+        if (it != m_fds.end()) {
+            Waiter& slot = for_write ? it->second.writer : it->second.reader;
+            if (slot.id == id) {
+                std::swap(slot.registration, registration);
+            }
+        }
+    }
+
+    // Called with m_mutex held.
+    void update_interest(int fd, FdState& state) {
+        epoll_event event{};
+        event.events = (state.reader ? EPOLLIN : 0u) | (state.writer ? EPOLLOUT : 0u);
+        event.data.fd = fd;
+        if (event.events == 0) {
+            if (state.registered) {
+                epoll_ctl(m_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            }
+            m_fds.erase(fd);
+            return;
+        }
+        epoll_ctl(m_epollFd, state.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event);
+        state.registered = true;
+    }
+
+    void loop() {
+        std::vector<epoll_event> events(64);
+        while (m_running.load(std::memory_order_acquire)) {
+            int count = epoll_wait(m_epollFd, events.data(), static_cast<int>(events.size()), -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == m_wakeFd) {
+                    std::uint64_t value;
+                    ssize_t bytes = ::read(m_wakeFd, &value, sizeof(value));
+                    (void)bytes;
+                    continue;
+                }
+                uint32_t ready = events[i].events;
+                bool readable = ready & (EPOLLIN | EPOLLHUP | EPOLLERR);
+                bool writable = ready & (EPOLLOUT | EPOLLHUP | EPOLLERR);
+                dispatch(fd, readable, writable);
+            }
+        }
+    }
+
+    void dispatch(int fd, bool readable, bool writable) {
+        Waiter reader;
+        Waiter writer;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_fds.find(fd);
+            if (it == m_fds.end()) {
+                return;
+            }
+            if (readable && it->second.reader && it->second.reader.attempt()) {
+                reader = std::move(it->second.reader);
+                it->second.reader = Waiter();
+            }
+            if (writable && it->second.writer && it->second.writer.attempt()) {
+                writer = std::move(it->second.writer);
+                it->second.writer = Waiter();
+            }
+            if (reader || writer) {
+                update_interest(fd, it->second);
+            }
+        }
+        // Completion runs outside the lock because it may post callbacks.
+        if (reader) {
+            reader.complete();
+        }
+        if (writer) {
+            writer.complete();
+        }
+    }
+
+    void wake() {
+        std::uint64_t one = 1;
+        ssize_t bytes = ::write(m_wakeFd, &one, sizeof(one));
+        (void)bytes;
+    }
+
+    void close_fds() {
+        if (m_epollFd >= 0) {
+            ::close(m_epollFd);
+            m_epollFd = -1;
+        }
+        if (m_wakeFd >= 0) {
+            ::close(m_wakeFd);
+            m_wakeFd = -1;
+        }
+    }
+
+    Executor m_executor;
+    int m_epollFd;
+    int m_wakeFd;
+    std::atomic<bool> m_running;
+    std::mutex m_mutex;
+    std::unordered_map<int, FdState> m_fds;
+    std::thread m_thread;
+};
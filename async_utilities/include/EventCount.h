@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Lets consumers of a lock-free structure sleep without a mutex. A consumer
+// calls prepare_wait(), re-checks its condition, then either cancel_wait()
+// or wait(key). Producers call notify_*() after publishing; the futex is
+// only touched while a consumer is waiting.
+class EventCount {
+public:
+    using Key = std::uint32_t;
+
+    EventCount() : m_epoch(0), m_waiters(0) {}
+
+    Key prepare_wait() {
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        return m_epoch.load(std::memory_order_seq_cst);
+    }
+
+    void cancel_wait() {
+        m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void wait(Key key) {
+        while (m_epoch.load(std::memory_order_acquire) == key) {
+            futex_wait(key);
+        }
+        m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    // Like wait(), but gives up after timeout. Returns false if it timed out
+    // without being notified.
+    bool wait_for(Key key, std::chrono::nanoseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        bool notified = true;
+        while (m_epoch.load(std::memory_order_acquire) == key) {
+            auto left = deadline - std::chrono::steady_clock::now();
+            if (left <= std::chrono::nanoseconds::zero()) {
+                notified = false;
+                break;
+            }
+            futex_wait(key, std::chrono::duration_cast<std::chrono::nanoseconds>(left));
+        }
+        m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+        return notified;
+    }
+
+    void notify_one() {
+        notify(false);
+    }
+
+    void notify_all() {
+        notify(true);
+    }
+
+    bool has_waiters() const {
+        return m_waiters.load(std::memory_order_acquire) != 0;
+    }
+
+private:
+    void notify(bool all) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        m_epoch.fetch_add(1, std::memory_order_release);
+        futex_wake(all);
+    }
+
+#ifdef __linux__
+    // std::atomic::wait in libstdc++ spins and backs off before it reaches
+    // the futex, which adds milliseconds of wakeup latency on busy machines.
+    void futex_wait(Key key) {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_epoch), FUTEX_WAIT_PRIVATE, key, nullptr, nullptr, 0);
+    }
+
+    void futex_wait(Key key, std::chrono::nanoseconds timeout) {
+        timespec relative{};
+        relative.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+        relative.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_epoch), FUTEX_WAIT_PRIVATE, key, &relative, nullptr, 0);
+    }
+
+    void futex_wake(bool all) {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_epoch), FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, nullptr, nullptr, 0);
+    }
+#else
+    void futex_wait(Key key) {
+        m_epoch.wait(key, std::memory_order_acquire);
+    }
+
+    // std::atomic::wait has no timeout; poll instead.
+    void futex_wait(Key key, std::chrono::nanoseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (m_epoch.load(std::memory_order_acquire) == key && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    void futex_wake(bool all) {
+        if (all) {
+            m_epoch.notify_all();
+        } else {
+            m_epoch.notify_one();
+        }
+    }
+#endif
+
+    std::atomic<Key> m_epoch;
+    std::atomic<std::uint32_t> m_waiters;
+
+    static_assert(sizeof(std::atomic<Key>) == sizeof(Key), "futex word must be a plain 32-bit integer");
+};
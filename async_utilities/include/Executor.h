@@ -0,0 +1,265 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+#include "ThreadPool.h"
+#include "CallbackDispatcher.h"
+#include "CancellableOperation.h"
+
+namespace detail {
+
+template<typename F, bool TakesToken = std::is_invocable_v<F&, const CancellationToken&>>
+struct OperationResult {
+    using type = std::invoke_result_t<F&, const CancellationToken&>;
+};
+
+template<typename F>
+struct OperationResult<F, false> {
+    using type = std::invoke_result_t<F&>;
+};
+
+template<typename F>
+using operation_result_t = typename OperationResult<std::decay_t<F>>::type;
+
+struct NoOp {
+    void operator()() const {}
+};
+
+} // namespace detail
+
+// Controls where an Executor runs operations and their callbacks. The
+// defaults deliver every callback through the dispatcher on the thread that
+// submitted the operation.
+struct ExecutionPolicy {
+    // If false, callbacks have no thread affinity: any thread draining the
+    // dispatcher may run them.
+    bool bind_callbacks = true;
+    // Callbacks without thread affinity run on the worker right after the
+    // operation instead of taking a trip through the dispatcher.
+    bool inline_callbacks = false;
+    // For tiny operations: run on the submitting thread instead of the pool
+    // when the pool is idle, saving the hand-off to a worker. Callbacks bound
+    // to the submitting thread are still posted, so they never run inside
+    // submit().
+    bool run_inline_if_idle = false;
+};
+
+// Result-type agnostic executor. Operations may take no arguments or the
+// operation's CancellationToken; the result type is deduced per call.
+class Executor {
+public:
+    using ExceptionCallback = std::function<void(std::string)>;
+
+    Executor(ThreadPool& threadPool, CallbackDispatcher& dispatcher, ExecutionPolicy policy = ExecutionPolicy())
+        : m_threadPool(threadPool), m_dispatcher(dispatcher), m_policy(policy) {}
+
+    // Executors are cheap to copy; this returns one sharing the pool and
+    // dispatcher but running under policy.
+    Executor with_policy(ExecutionPolicy policy) const {
+        return Executor(m_threadPool, m_dispatcher, policy);
+    }
+
+    const ExecutionPolicy& policy() const {
+        return m_policy;
+    }
+
+    // The thread that callbacks of operations submitted from the calling
+    // thread are bound to, or no thread when the policy does not bind them.
+    // Pass it to run() when completing an operation from another thread.
+    std::thread::id callback_thread() const {
+        return m_policy.bind_callbacks ? std::this_thread::get_id() : std::thread::id();
+    }
+
+    template<typename F, typename R = detail::operation_result_t<F>>
+    Operation<R> submit(F&& operation,
+                        std::optional<typename CancellableOperation<R>::Callback> callback = std::nullopt,
+                        const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                        const CancellationToken& parent_token = CancellationToken()) {
+        auto cancellableOp = make_operation(std::forward<F>(operation), std::move(callback), parent_token);
+        schedule(cancellableOp, exception_callback, callback_thread(), false);
+        return cancellableOp;
+    }
+
+    // Like submit(), but returns nullptr instead of throwing or blocking when
+    // the thread pool refuses the operation.
+    template<typename F, typename R = detail::operation_result_t<F>>
+    Operation<R> try_submit(F&& operation,
+                            std::optional<typename CancellableOperation<R>::Callback> callback = std::nullopt,
+                            const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                            const CancellationToken& parent_token = CancellationToken()) {
+        auto cancellableOp = make_operation(std::forward<F>(operation), std::move(callback), parent_token);
+        if (!schedule(cancellableOp, exception_callback, callback_thread(), true)) {
+            return nullptr;
+        }
+        return cancellableOp;
+    }
+
+    // Holds the operation back until limiter admits it, so limited work does
+    // not occupy a pool thread while it waits. Limiter is an AsyncSemaphore,
+    // RateLimiter or anything with acquire(continuation, token) and
+    // release(); release() is called once the operation has run or been
+    // dropped, so the limiter must outlive the operation. Admitted
+    // operations never block on a full pool: if the pool refuses them they
+    // are cancelled.
+    template<typename Limiter, typename F, typename R = detail::operation_result_t<F>>
+    Operation<R> submit_limited(Limiter& limiter, F&& operation,
+                                std::optional<typename CancellableOperation<R>::Callback> callback = std::nullopt,
+                                const std::optional<ExceptionCallback>& exception_callback = std::nullopt,
+                                const CancellationToken& parent_token = CancellationToken()) {
+        auto cancellableOp = make_operation(std::forward<F>(operation), std::move(callback), parent_token);
+        limiter.acquire([executor = *this, &limiter, cancellableOp, exception_callback,
+                         current_thread_id = callback_thread()]() mutable {
+            executor.schedule(cancellableOp, exception_callback, current_thread_id, true,
+                              [&limiter]() { limiter.release(); });
+        }, cancellableOp->getCancellationToken());
+        return cancellableOp;
+    }
+
+    // Creates an operation without scheduling it. Completion sources such as
+    // reactors hand it back to run() on their own thread once it can finish.
+    template<typename F, typename R = detail::operation_result_t<F>>
+    Operation<R> make_operation(F&& operation,
+                                std::optional<typename CancellableOperation<R>::Callback> callback = std::nullopt,
+                                const CancellationToken& parent_token = CancellationToken()) const {
+        using OperationFn = typename CancellableOperation<R>::Operation;
+        OperationFn operationFn;
+        if constexpr (std::is_invocable_v<std::decay_t<F>&, const CancellationToken&>) {
+            operationFn = std::forward<F>(operation);
+        } else {
+            operationFn = [op = std::forward<F>(operation)](const CancellationToken&) mutable -> R {
+                return op();
+            };
+        }
+        return std::make_shared<CancellableOperation<R>>(std::move(operationFn), std::move(callback), parent_token);
+    }
+
+    // Executes the operation on the calling thread and posts its callback to
+    // the dispatcher for callback_thread_id, or runs it right here if it has
+    // no thread affinity and the policy asks for inline callbacks.
+    template<typename R>
+    void run(const Operation<R>& cancellableOp, const std::optional<ExceptionCallback>& exception_callback,
+             std::thread::id callback_thread_id) {
+        if (cancellableOp->isCancelled()) {
+            return;
+        }
+
+        try {
+            cancellableOp->execute();
+            if (cancellableOp->isCancelled() || !cancellableOp->hasCallback()) {
+                return;
+            }
+            auto deliver = [cancellableOp, exception_callback]() {
+                bool cancelled = cancellableOp->isCancelled();
+                bool finished = cancellableOp->isFinished();
+
+                if (cancelled || finished) {
+                    return;
+                }
+                try {
+                    cancellableOp->callback();
+                } catch (const std::exception& e) {
+                    report("Callback exception: ", e, exception_callback);
+                }
+            };
+            if (m_policy.inline_callbacks && callback_thread_id == std::thread::id()) {
+                deliver();
+            } else {
+                m_dispatcher.post(std::move(deliver), callback_thread_id);
+            }
+        } catch (const OperationCancelledException&) {
+            cancellableOp->setPromiseException(std::current_exception());
+        } catch (const std::exception& e) {
+            report("Operation exception: ", e, exception_callback);
+            cancellableOp->setPromiseException(std::current_exception());
+        }
+    }
+
+    // Shuts the pool down in mode (see ShutdownMode). Operations the pool
+    // discards are cancelled, so their futures throw
+    // OperationCancelledException. Unless pending work is cancelled, the
+    // callbacks the drained operations posted for the calling thread (or
+    // for no thread in particular) run here before the dispatcher stops.
+    void shutdown(ShutdownMode mode = ShutdownMode::Drain,
+                  std::chrono::steady_clock::duration timeout = std::chrono::steady_clock::duration::zero()) const {
+        m_threadPool.shutdown(mode, timeout);
+        if (mode != ShutdownMode::CancelPending) {
+            m_dispatcher.execute_pending();
+        }
+        m_dispatcher.stop();
+    }
+
+    // Waits until the pool has no operation queued or running; see
+    // ThreadPool::wait_idle.
+    void wait_idle() const {
+        m_threadPool.wait_idle();
+    }
+
+    ThreadPool& thread_pool() const {
+        return m_threadPool;
+    }
+
+    CallbackDispatcher& dispatcher() const {
+        return m_dispatcher;
+    }
+
+private:
+    // Operations the pool drops or refuses are cancelled, so their futures
+    // do not wait forever. on_finish runs exactly once, after the operation
+    // has run or once it has been dropped or refused.
+    template<typename R, typename OnFinish = detail::NoOp>
+    bool schedule(const Operation<R>& cancellableOp, const std::optional<ExceptionCallback>& exception_callback,
+                  std::thread::id current_thread_id, bool non_blocking, OnFinish on_finish = OnFinish()) {
+        if (m_policy.run_inline_if_idle && m_threadPool.is_idle()) {
+            run(cancellableOp, exception_callback, current_thread_id);
+            on_finish();
+            return true;
+        }
+        ThreadPool::Task task = m_threadPool.guard_drop(
+            [executor = *this, cancellableOp, current_thread_id, exception_callback, on_finish]() mutable {
+                executor.run(cancellableOp, exception_callback, current_thread_id);
+                on_finish();
+            },
+            [cancellableOp, on_finish]() {
+                cancellableOp->cancel();
+                on_finish();
+            });
+        try {
+            if (non_blocking) {
+                if (m_threadPool.try_enqueue(std::move(task))) {
+                    return true;
+                }
+            } else {
+                m_threadPool.enqueue(std::move(task));
+                return true;
+            }
+        } catch (const RejectedExecutionException&) {
+            cancellableOp->cancel();
+            on_finish();
+            throw;
+        }
+        cancellableOp->cancel();
+        on_finish();
+        return false;
+    }
+
+    static void report(const char* prefix, const std::exception& e,
+                       const std::optional<ExceptionCallback>& exception_callback) {
+        std::ostringstream oss;
+        oss << prefix << e.what() << std::endl;
+        const std::string error_message = oss.str();
+        if (exception_callback) {
+            (*exception_callback)(error_message);
+        } else {
+            std::cerr << error_message;
+        }
+    }
+
+    ThreadPool& m_threadPool;
+    CallbackDispatcher& m_dispatcher;
+    ExecutionPolicy m_policy;
+};
@@ -0,0 +1,234 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "SchedulePoint.h"
+
+// Hazard pointers (Michael, 2004) for the lock-free containers. A thread
+// publishes the node it is about to dereference; retired nodes are only
+// deleted once no hazard pointer refers to them.
+namespace detail {
+
+struct HazardRecord {
+    std::atomic<void*> pointer{nullptr};
+    std::atomic<bool> active{false};
+    HazardRecord* next{nullptr};
+};
+
+struct RetiredNode {
+    void* pointer;
+    void (*deleter)(void*, void*);
+    void* context;
+};
+
+class HazardDomain {
+public:
+    static HazardDomain& instance() {
+        static HazardDomain domain;
+        return domain;
+    }
+
+    ~HazardDomain() {
+        for (auto& node : m_orphans) {
+            node.deleter(node.pointer, node.context);
+        }
+        HazardRecord* record = m_records.load(std::memory_order_acquire);
+        while (record) {
+            HazardRecord* next = record->next;
+            delete record;
+            record = next;
+        }
+    }
+
+    HazardRecord* acquire_record() {
+        for (HazardRecord* record = m_records.load(std::memory_order_acquire); record; record = record->next) {
+            bool expected = false;
+            if (!record->active.load(std::memory_order_relaxed) &&
+                record->active.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                return record;
+            }
+        }
+
+        auto* record = new HazardRecord();
+        record->active.store(true, std::memory_order_relaxed);
+        HazardRecord* head = m_records.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!m_records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+        m_recordCount.fetch_add(1, std::memory_order_relaxed);
+        return record;
+    }
+
+    void release_record(HazardRecord* record) {
+        record->pointer.store(nullptr, std::memory_order_release);
+        record->active.store(false, std::memory_order_release);
+    }
+
+    size_t scan_threshold() const {
+        return std::max<size_t>(64, 2 * m_recordCount.load(std::memory_order_relaxed));
+    }
+
+    // Deletes every retired node that is not currently protected; the rest
+    // stay in retired.
+    void scan(std::vector<RetiredNode>& retired) {
+        {
+            std::lock_guard<std::mutex> lock(m_orphanMutex);
+            if (!m_orphans.empty()) {
+                retired.insert(retired.end(), m_orphans.begin(), m_orphans.end());
+                m_orphans.clear();
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<void*> hazards;
+        for (HazardRecord* record = m_records.load(std::memory_order_acquire); record; record = record->next) {
+            if (void* pointer = record->pointer.load(std::memory_order_acquire)) {
+                hazards.push_back(pointer);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+
+        std::vector<RetiredNode> reclaimable;
+        auto protected_end = std::partition(retired.begin(), retired.end(), [&hazards](const RetiredNode& node) {
+            return std::binary_search(hazards.begin(), hazards.end(), node.pointer);
+        });
+        reclaimable.assign(protected_end, retired.end());
+        retired.erase(protected_end, retired.end());
+
+        // Deleters may run arbitrary destructors, including ones that retire
+        // more nodes, so they run after the list has been updated.
+        for (auto& node : reclaimable) {
+            node.deleter(node.pointer, node.context);
+        }
+    }
+
+    void adopt_orphans(std::vector<RetiredNode>& retired) {
+        std::lock_guard<std::mutex> lock(m_orphanMutex);
+        m_orphans.insert(m_orphans.end(), retired.begin(), retired.end());
+        retired.clear();
+    }
+
+private:
+    HazardDomain() = default;
+
+    std::atomic<HazardRecord*> m_records{nullptr};
+    std::atomic<size_t> m_recordCount{0};
+    std::mutex m_orphanMutex;
+    std::vector<RetiredNode> m_orphans;
+};
+
+// Records acquired by a thread are cached and handed back to the domain when
+// the thread exits.
+class ThreadHazardCache {
+public:
+    static ThreadHazardCache& instance() {
+        thread_local ThreadHazardCache cache;
+        return cache;
+    }
+
+    ~ThreadHazardCache() {
+        HazardDomain& domain = HazardDomain::instance();
+        while (!m_retired.empty()) {
+            size_t before = m_retired.size();
+            domain.scan(m_retired);
+            if (m_retired.size() == before) {
+                break;
+            }
+        }
+        domain.adopt_orphans(m_retired);
+        for (HazardRecord* record : m_free) {
+            domain.release_record(record);
+        }
+    }
+
+    HazardRecord* acquire() {
+        if (m_free.empty()) {
+            return m_domain.acquire_record();
+        }
+        HazardRecord* record = m_free.back();
+        m_free.pop_back();
+        return record;
+    }
+
+    void release(HazardRecord* record) {
+        record->pointer.store(nullptr, std::memory_order_release);
+        m_free.push_back(record);
+    }
+
+    void retire(RetiredNode node) {
+        m_retired.push_back(node);
+        if (!m_scanning && m_retired.size() >= m_domain.scan_threshold()) {
+            m_scanning = true;
+            m_domain.scan(m_retired);
+            m_scanning = false;
+        }
+    }
+
+private:
+    ThreadHazardCache() : m_domain(HazardDomain::instance()), m_scanning(false) {}
+
+    HazardDomain& m_domain;
+    std::vector<HazardRecord*> m_free;
+    std::vector<RetiredNode> m_retired;
+    bool m_scanning;
+};
+
+} // namespace detail
+
+class HazardPointer {
+public:
+    HazardPointer() : m_record(detail::ThreadHazardCache::instance().acquire()) {}
+
+    ~HazardPointer() {
+        detail::ThreadHazardCache::instance().release(m_record);
+    }
+
+    HazardPointer(const HazardPointer&) = delete;
+    HazardPointer& operator=(const HazardPointer&) = delete;
+
+    // Loads source and publishes the loaded pointer, retrying until the
+    // published value is still current.
+    template<typename T>
+    T* protect(const std::atomic<T*>& source) {
+        T* pointer = source.load(std::memory_order_relaxed);
+        while (true) {
+            m_record->pointer.store(pointer, std::memory_order_seq_cst);
+            ASYNC_SCHEDULE_POINT();
+            T* current = source.load(std::memory_order_seq_cst);
+            if (current == pointer) {
+                return pointer;
+            }
+            pointer = current;
+        }
+    }
+
+    template<typename T>
+    void set(T* pointer) {
+        m_record->pointer.store(pointer, std::memory_order_seq_cst);
+    }
+
+    void reset() {
+        m_record->pointer.store(nullptr, std::memory_order_release);
+    }
+
+private:
+    detail::HazardRecord* m_record;
+};
+
+template<typename T>
+void retire_hazard_pointer(T* pointer) {
+    detail::ThreadHazardCache::instance().retire(
+        {pointer, [](void* p, void*) { delete static_cast<T*>(p); }, nullptr});
+}
+
+// Calls Reclaim(pointer, context) instead of deleting pointer once no hazard
+// pointer refers to it.
+template<auto Reclaim, typename T, typename Context>
+void retire_hazard_pointer(T* pointer, Context* context) {
+    detail::ThreadHazardCache::instance().retire(
+        {pointer, [](void* p, void* c) { Reclaim(static_cast<T*>(p), static_cast<Context*>(c)); }, context});
+}
@@ -4,21 +4,108 @@
 
 #pragma once
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <optional>
-
-template <typename T>
+#include "ContainerPolicy.h"
+#include "HazardPointer.h"
+#include "SchedulePoint.h"
+
+// Harris-Michael list: a node is removed by first marking its next pointer,
+// which stops concurrent inserts after it, and then unlinking it. Traversals
+// unlink marked nodes they pass and protect the nodes they hold with hazard
+// pointers, so removed nodes are only freed once nobody can reach them.
+template <typename T, typename Policy = DefaultContainerPolicy>
+    requires ContainerPolicyFor<Policy, T>
 class LockFreeList {
 private:
     struct Node {
-        std::shared_ptr<T> data;
+        detail::NodeValue<T, Policy::storage> value;
         std::atomic<Node*> next;
 
         Node() : next(nullptr) {}
-        Node(const T& value) : data(std::make_shared<T>(value)), next(nullptr) {}
     };
 
-    std::atomic<Node*> head;
+    using Orders = detail::MemoryOrders<Policy>;
+
+    Node* make_node(const T& value) {
+        Node* node = reserve.take();
+        if (!node) {
+            node = new Node();
+        }
+        node->value.emplace(value);
+        return node;
+    }
+
+    static bool is_marked(Node* pointer) {
+        return (reinterpret_cast<std::uintptr_t>(pointer) & 1) != 0;
+    }
+
+    static Node* marked(Node* pointer) {
+        return reinterpret_cast<Node*>(reinterpret_cast<std::uintptr_t>(pointer) | 1);
+    }
+
+    static Node* unmarked(Node* pointer) {
+        return reinterpret_cast<Node*>(reinterpret_cast<std::uintptr_t>(pointer) & ~std::uintptr_t(1));
+    }
+
+    // Hazard pointers for the node owning prev, the current node and its
+    // successor; their roles rotate as the traversal advances.
+    struct Cursor {
+        HazardPointer hazards[3];
+        HazardPointer* hp_prev = &hazards[0];
+        HazardPointer* hp_current = &hazards[1];
+        HazardPointer* hp_next = &hazards[2];
+        std::atomic<Node*>* prev = nullptr;
+        Node* current = nullptr;
+        Node* next = nullptr;
+    };
+
+    // Positions cursor on the first unmarked node holding value, with
+    // prev pointing at the link to it. Returns false, with current null, if
+    // there is none.
+    bool search(const T& value, Cursor& cursor) const {
+    retry:
+        cursor.prev = &head;
+        cursor.hp_prev->reset();
+        cursor.current = cursor.hp_current->protect(head);
+        while (cursor.current) {
+            ASYNC_SCHEDULE_POINT();
+            Node* next = cursor.current->next.load(Orders::consume);
+            cursor.hp_next->set(unmarked(next));
+            if (cursor.current->next.load(Orders::consume) != next ||
+                cursor.prev->load(Orders::consume) != cursor.current) {
+                goto retry;
+            }
+            if (is_marked(next)) {
+                // Help unlink the removed node; only the thread whose CAS
+                // succeeds retires it.
+                Node* expected = cursor.current;
+                if (!cursor.prev->compare_exchange_strong(expected, unmarked(next),
+                                                          Orders::exchange,
+                                                          std::memory_order_relaxed)) {
+                    goto retry;
+                }
+                reserve.retire(cursor.current);
+                std::swap(cursor.hp_current, cursor.hp_next);
+                cursor.current = unmarked(next);
+                continue;
+            }
+            if (cursor.current->value.get() == value) {
+                cursor.next = next;
+                return true;
+            }
+            cursor.prev = &cursor.current->next;
+            std::swap(cursor.hp_prev, cursor.hp_current);
+            std::swap(cursor.hp_current, cursor.hp_next);
+            cursor.current = next;
+        }
+        return false;
+    }
+
+    // Mutable because read-only traversals still unlink removed nodes.
+    mutable detail::AtomicEnd<Node*, Policy::pad_ends> head;
+    detail::NodeReserve<Node, Policy::capacity_hint> reserve;
 
 public:
     LockFreeList() : head(nullptr) {}
@@ -26,90 +113,83 @@ public:
     ~LockFreeList() {
         Node* current = head.load(std::memory_order_relaxed);
         while (current) {
-            Node* next = current->next.load(std::memory_order_relaxed);
+            Node* next = unmarked(current->next.load(std::memory_order_relaxed));
             delete current;
             current = next;
         }
     }
 
-    void insert_after(const T& value, const T& after_value) {
-        Node* new_node = new Node(value);
-        Node* current = head.load(std::memory_order_acquire);
+    // Inserts value after the first node holding after_value. Returns false
+    // if there is no such node.
+    bool insert_after(const T& value, const T& after_value) {
+        Node* new_node = make_node(value);
+        Cursor cursor;
 
         while (true) {
-            while (current && *(current->data) != after_value) {
-                current = current->next.load(std::memory_order_acquire);
-            }
-
-            if (!current) {
+            if (!search(after_value, cursor)) {
                 delete new_node;
-                return;  // Value not found, insertion failed
+                return false;
             }
 
-            new_node->next.store(current->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
-
-            if (current->next.compare_exchange_weak(new_node->next.load(std::memory_order_relaxed), new_node,
-                                                    std::memory_order_release, std::memory_order_relaxed)) {
-                return;  // Insertion successful
+            new_node->next.store(cursor.next, std::memory_order_relaxed);
+            ASYNC_SCHEDULE_POINT();
+            // Fails if a node was inserted after current or current was
+            // marked for removal in the meantime.
+            Node* expected = cursor.next;
+            if (cursor.current->next.compare_exchange_strong(expected, new_node,
+                                                             Orders::publish,
+                                                             std::memory_order_relaxed)) {
+                return true;
             }
         }
     }
 
     void insert_beginning(const T& value) {
-        Node* new_node = new Node(value);
+        Node* new_node = make_node(value);
         Node* old_head = head.load(std::memory_order_relaxed);
 
         do {
             new_node->next.store(old_head, std::memory_order_relaxed);
+            ASYNC_SCHEDULE_POINT();
         } while (!head.compare_exchange_weak(old_head, new_node,
-                                             std::memory_order_release, std::memory_order_relaxed));
+                                             Orders::publish, std::memory_order_relaxed));
     }
 
     bool remove(const T& value) {
-        Node* current = head.load(std::memory_order_acquire);
-        Node* prev = nullptr;
+        Cursor cursor;
 
-        while (current && *(current->data) != value) {
-            prev = current;
-            current = current->next.load(std::memory_order_acquire);
-        }
+        while (true) {
+            if (!search(value, cursor)) {
+                return false;  // Value not found
+            }
 
-        if (!current) {
-            return false;  // Value not found
-        }
+            ASYNC_SCHEDULE_POINT();
+            Node* next = cursor.next;
+            if (!cursor.current->next.compare_exchange_strong(next, marked(next),
+                                                              Orders::exchange,
+                                                              std::memory_order_relaxed)) {
+                continue;  // Successor changed or another thread removed it first
+            }
 
-        Node* next = current->next.load(std::memory_order_acquire);
-
-        if (prev) {
-            if (!prev->next.compare_exchange_strong(current, next,
-                                                    std::memory_order_release,
-                                                    std::memory_order_relaxed)) {
-                return false;  // Node has been removed by another thread
-                                                    }
-        } else {
-            if (!head.compare_exchange_strong(current, next,
-                                              std::memory_order_release,
-                                              std::memory_order_relaxed)) {
-                return false;  // Head has been changed by another thread
-                                              }
+            ASYNC_SCHEDULE_POINT();
+            Node* expected = cursor.current;
+            if (cursor.prev->compare_exchange_strong(expected, cursor.next,
+                                                     Orders::exchange,
+                                                     std::memory_order_relaxed)) {
+                reserve.retire(cursor.current);
+            } else {
+                // Someone changed prev; a fresh traversal unlinks the node.
+                search(value, cursor);
+            }
+            return true;
         }
-
-        // Defer deletion to avoid race condition
-        std::atomic_thread_fence(std::memory_order_acquire);
-        delete current;
-        return true;
     }
 
     std::optional<T> find(const T& value) const {
-        Node* current = head.load(std::memory_order_acquire);
-
-        while (current) {
-            if (*(current->data) == value) {
-                return *(current->data);
-            }
-            current = current->next.load(std::memory_order_acquire);
+        Cursor cursor;
+        if (!search(value, cursor)) {
+            return std::nullopt;
         }
-
-        return std::nullopt;
+        return cursor.current->value.get();
     }
 };
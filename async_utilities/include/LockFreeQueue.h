@@ -2,21 +2,27 @@
 #include <atomic>
 #include <memory>
 #include <optional>
+#include "ContainerPolicy.h"
+#include "HazardPointer.h"
+#include "SchedulePoint.h"
 
 
-template <typename T>
+template <typename T, typename Policy = DefaultContainerPolicy>
+    requires ContainerPolicyFor<Policy, T>
 class LockFreeQueue {
 private:
     struct Node {
-        std::shared_ptr<T> data;
+        detail::NodeValue<T, Policy::storage> value;
         std::atomic<Node*> next;
 
         Node() : next(nullptr) {}
-        explicit Node(const T& value) : data(std::make_shared<T>(value)), next(nullptr) {}
     };
 
-    std::atomic<Node*> head;
-    std::atomic<Node*> tail;
+    using Orders = detail::MemoryOrders<Policy>;
+
+    detail::AtomicEnd<Node*, Policy::pad_ends> head;
+    detail::AtomicEnd<Node*, Policy::pad_ends> tail;
+    detail::NodeReserve<Node, Policy::capacity_hint> reserve;
 
 public:
     LockFreeQueue() {
@@ -27,29 +33,37 @@ public:
 
     ~LockFreeQueue() {
         while (Node* old_head = head.load(std::memory_order_relaxed)) {
-            head.store(old_head->next, std::memory_order_relaxed);
+            head.store(old_head->next.load(std::memory_order_relaxed), std::memory_order_relaxed);
             delete old_head;
         }
     }
 
     void enqueue(T value) {
-        Node* new_node = new Node(std::move(value));
+        Node* new_node = reserve.take();
+        if (!new_node) {
+            new_node = new Node();
+        }
+        new_node->value.emplace(std::move(value));
+        HazardPointer hp_tail;
         while (true) {
-            Node* old_tail = tail.load(std::memory_order_acquire);
-            Node* next = old_tail->next.load(std::memory_order_acquire);
-            if (old_tail == tail.load(std::memory_order_acquire)) {
+            Node* old_tail = hp_tail.protect(tail);
+            ASYNC_SCHEDULE_POINT();
+            Node* next = old_tail->next.load(Orders::consume);
+            ASYNC_SCHEDULE_POINT();
+            if (old_tail == tail.load(Orders::consume)) {
                 if (next == nullptr) {
                     if (old_tail->next.compare_exchange_weak(next, new_node,
-                                                             std::memory_order_release,
+                                                             Orders::publish,
                                                              std::memory_order_relaxed)) {
+                        ASYNC_SCHEDULE_POINT();
                         tail.compare_exchange_strong(old_tail, new_node,
-                                                     std::memory_order_release,
+                                                     Orders::publish,
                                                      std::memory_order_relaxed);
                         return;
                     }
                 } else {
                     tail.compare_exchange_weak(old_tail, next,
-                                               std::memory_order_release,
+                                               Orders::publish,
                                                std::memory_order_relaxed);
                 }
             }
@@ -57,41 +71,50 @@ public:
     }
 
     std::optional<T> dequeue() {
+        HazardPointer hp_head;
+        HazardPointer hp_next;
         while (true) {
-            Node* old_head = head.load(std::memory_order_acquire);
-            Node* old_tail = tail.load(std::memory_order_acquire);
-            Node* next = old_head->next.load(std::memory_order_acquire);
+            Node* old_head = hp_head.protect(head);
+            ASYNC_SCHEDULE_POINT();
+            Node* old_tail = tail.load(Orders::consume);
+            Node* next = old_head->next.load(Orders::consume);
+            hp_next.set(next);
+            ASYNC_SCHEDULE_POINT();
 
-            if (old_head == head.load(std::memory_order_acquire)) {
+            if (old_head == head.load(Orders::consume)) {
                 if (old_head == old_tail) {
                     if (next == nullptr) {
                         return std::nullopt;  // Queue is empty
                     }
                     tail.compare_exchange_weak(old_tail, next,
-                                               std::memory_order_release,
+                                               Orders::publish,
                                                std::memory_order_relaxed);
-                } else {
-                    if (next && next->data) {
-                        T result = std::move(*next->data);
-                        if (head.compare_exchange_weak(old_head, next,
-                                                       std::memory_order_release,
-                                                       std::memory_order_relaxed)) {
-                            delete old_head;
-                            return result;
-                        }
-                    } else {
-                        // Skip this node if it's invalid
-                        head.compare_exchange_weak(old_head, next,
-                                                   std::memory_order_release,
-                                                   std::memory_order_relaxed);
-                    }
+                } else if (head.compare_exchange_weak(old_head, next,
+                                                      Orders::exchange,
+                                                      std::memory_order_relaxed)) {
+                    // Only the thread that advanced head reads the payload of
+                    // the new dummy node, and hp_next keeps it alive.
+                    std::optional<T> result(next->value.take());
+                    hp_head.reset();
+                    reserve.retire(old_head);
+                    return result;
                 }
             }
         }
     }
 
+    bool dequeue(T& value) {
+        std::optional<T> result = dequeue();
+        if (!result) {
+            return false;
+        }
+        value = std::move(*result);
+        return true;
+    }
+
     bool is_empty() const {
-        Node* front = head.load(std::memory_order_acquire);
-        return front->next.load(std::memory_order_acquire) == nullptr;
+        HazardPointer hp_head;
+        Node* front = hp_head.protect(head);
+        return front->next.load(Orders::consume) == nullptr;
     }
 };
@@ -6,18 +6,25 @@
 #include <atomic>
 #include <memory>
 #include <optional>
+#include "ContainerPolicy.h"
+#include "HazardPointer.h"
+#include "SchedulePoint.h"
 
-template <typename T>
+template <typename T, typename Policy = DefaultContainerPolicy>
+    requires ContainerPolicyFor<Policy, T>
 class LockFreeStack {
 private:
     struct Node {
-        std::shared_ptr<T> data;
+        detail::NodeValue<T, Policy::storage> value;
         std::atomic<Node*> next;
 
-        Node(const T& value) : data(std::make_shared<T>(value)), next(nullptr) {}
+        Node() : next(nullptr) {}
     };
 
-    std::atomic<Node*> top;
+    using Orders = detail::MemoryOrders<Policy>;
+
+    detail::AtomicEnd<Node*, Policy::pad_ends> top;
+    detail::NodeReserve<Node, Policy::capacity_hint> reserve;
 
 public:
     LockFreeStack() : top(nullptr) {}
@@ -30,30 +37,43 @@ public:
     }
 
     void push(const T& value) {
-        Node* new_node = new Node(value);
+        Node* new_node = reserve.take();
+        if (!new_node) {
+            new_node = new Node();
+        }
+        new_node->value.emplace(value);
         Node* old_top = top.load(std::memory_order_relaxed);
         do {
             new_node->next.store(old_top, std::memory_order_relaxed);
+            ASYNC_SCHEDULE_POINT();
         } while (!top.compare_exchange_weak(old_top, new_node,
-                                            std::memory_order_release,
+                                            Orders::publish,
                                             std::memory_order_relaxed));
     }
 
+    // old_top is protected by a hazard pointer while its successor is read,
+    // so it cannot be freed, or freed and reused (ABA), under the CAS.
     std::optional<T> pop() {
-        Node* old_top = top.load(std::memory_order_relaxed);
-        Node* new_top;
-        do {
+        HazardPointer hp_top;
+        Node* old_top;
+        while (true) {
+            old_top = hp_top.protect(top);
             if (old_top == nullptr) {
                 return std::nullopt;  // Stack is empty
             }
-            new_top = old_top->next.load(std::memory_order_relaxed);
-        } while (!top.compare_exchange_weak(old_top, new_top,
-                                            std::memory_order_release,
-                                            std::memory_order_relaxed));
+            ASYNC_SCHEDULE_POINT();
+            Node* new_top = old_top->next.load(std::memory_order_relaxed);
+            ASYNC_SCHEDULE_POINT();
+            if (top.compare_exchange_weak(old_top, new_top,
+                                          Orders::consume,
+                                          std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        hp_top.reset();
 
-        std::optional<T> result = *(old_top->data);
-        std::atomic_thread_fence(std::memory_order_acquire);
-        delete old_top;
+        std::optional<T> result(old_top->value.take());
+        reserve.retire(old_top);
         return result;
     }
 
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include "EventCount.h"
+#include "LockFreeQueue.h"
+#include "SchedulePoint.h"
+
+// Drop-in replacement for TaskQueue. push() and the non-empty pop() path are
+// lock-free; pop() only parks on the EventCount when the queue is empty, and
+// push() only issues a wakeup when a consumer is parked.
+class LockFreeTaskQueue {
+public:
+    using Task = std::function<void()>;
+
+    LockFreeTaskQueue() : m_stopped(false) {}
+
+    void push(Task task) {
+        m_tasks.enqueue(std::move(task));
+        ASYNC_SCHEDULE_POINT();
+        m_event.notify_one();
+    }
+
+    bool try_pop(Task& task) {
+        return m_tasks.dequeue(task);
+    }
+
+    // Blocks until a task is available. Returns false once the queue has
+    // been stopped and drained.
+    bool pop(Task& task) {
+        while (true) {
+            if (try_pop(task)) {
+                return true;
+            }
+            if (m_stopped.load(std::memory_order_acquire)) {
+                return try_pop(task);
+            }
+            if (spin_pop(task)) {
+                return true;
+            }
+
+            EventCount::Key key = m_event.prepare_wait();
+            ASYNC_SCHEDULE_POINT();
+            if (try_pop(task)) {
+                m_event.cancel_wait();
+                return true;
+            }
+            if (m_stopped.load(std::memory_order_seq_cst)) {
+                m_event.cancel_wait();
+                return try_pop(task);
+            }
+            m_event.wait(key);
+        }
+    }
+
+    void stop() {
+        m_stopped.store(true, std::memory_order_release);
+        m_event.notify_all();
+    }
+
+    bool is_stopped() const {
+        return m_stopped.load(std::memory_order_acquire);
+    }
+
+    bool is_empty() const {
+        return m_tasks.is_empty();
+    }
+
+private:
+    bool spin_pop(Task& task) {
+        for (int i = 0; i < 16; ++i) {
+            std::this_thread::yield();
+            if (try_pop(task)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    LockFreeQueue<Task> m_tasks;
+    EventCount m_event;
+    std::atomic<bool> m_stopped;
+};
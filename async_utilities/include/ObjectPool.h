@@ -0,0 +1,433 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "HazardPointer.h"
+
+struct ObjectPoolStats {
+    size_t acquired = 0;
+    size_t local_hits = 0;   // served from the calling thread's cache
+    size_t global_hits = 0;  // served from a batch taken off the shared free list
+    size_t allocated = 0;    // misses that had to construct a new object
+    size_t cached = 0;       // objects currently on the shared free list
+
+    double hit_rate() const {
+        return acquired == 0 ? 0.0 : static_cast<double>(local_hits + global_hits) / static_cast<double>(acquired);
+    }
+
+    ObjectPoolStats& operator+=(const ObjectPoolStats& other) {
+        acquired += other.acquired;
+        local_hits += other.local_hits;
+        global_hits += other.global_hits;
+        allocated += other.allocated;
+        cached += other.cached;
+        return *this;
+    }
+};
+
+// Concurrent pool of reusable objects. Each thread keeps a small cache that
+// it serves without synchronisation; caches exchange objects with a shared
+// lock-free stack in batches, so the shared stack is touched once per
+// batch rather than once per object. Batch nodes are reclaimed through
+// hazard pointers and never reused, which keeps the stack free of ABA.
+//
+// Handles return their object to the pool on destruction and must not
+// outlive the pool.
+template<typename T>
+class ObjectPool {
+    class Core;
+
+public:
+    using Factory = std::function<std::unique_ptr<T>()>;
+    using Recycler = std::function<void(T&)>;
+
+    struct Options {
+        size_t thread_cache_size = 32;
+        // Objects released while the shared free list already holds this
+        // many are destroyed instead of cached.
+        size_t max_cached = std::numeric_limits<size_t>::max();
+    };
+
+    class Handle {
+    public:
+        Handle() : m_core(nullptr), m_object(nullptr) {}
+
+        Handle(Handle&& other) noexcept
+            : m_core(std::exchange(other.m_core, nullptr)), m_object(std::exchange(other.m_object, nullptr)) {}
+
+        Handle& operator=(Handle&& other) noexcept {
+            if (this != &other) {
+                reset();
+                m_core = std::exchange(other.m_core, nullptr);
+                m_object = std::exchange(other.m_object, nullptr);
+            }
+            return *this;
+        }
+
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        ~Handle() {
+            reset();
+        }
+
+        T* get() const { return m_object; }
+        T& operator*() const { return *m_object; }
+        T* operator->() const { return m_object; }
+        explicit operator bool() const { return m_object != nullptr; }
+
+        // Returns the object to its pool. Handles without a pool own their
+        // object outright and delete it.
+        void reset() {
+            if (!m_object) {
+                return;
+            }
+            if (m_core) {
+                m_core->release(m_object);
+            } else {
+                delete m_object;
+            }
+            m_core = nullptr;
+            m_object = nullptr;
+        }
+
+    private:
+        friend class ObjectPool;
+
+        Handle(Core* core, T* object) : m_core(core), m_object(object) {}
+
+        Core* m_core;
+        T* m_object;
+    };
+
+    explicit ObjectPool(Factory factory = [] { return std::make_unique<T>(); },
+                        Recycler recycler = nullptr, Options options = Options())
+        : m_core(std::make_shared<Core>(std::move(factory), std::move(recycler), options)) {}
+
+    // Objects cached by other threads are destroyed when those threads
+    // exit or next create a cache.
+    ~ObjectPool() {
+        local_caches().forget(m_core->id());
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    Handle acquire() {
+        return Handle(m_core.get(), m_core->acquire());
+    }
+
+    // Wraps an object that does not belong to any pool, e.g. an oversized
+    // request that should not be cached.
+    static Handle unpooled(std::unique_ptr<T> object) {
+        return Handle(nullptr, object.release());
+    }
+
+    // Moves the calling thread's cache to the shared free list, then
+    // destroys cached objects until at most keep remain there. Other
+    // threads' caches are left alone.
+    void trim(size_t keep = 0) {
+        m_core->flush_local();
+        m_core->trim(keep);
+    }
+
+    // Counters from other threads lag by up to one batch; the calling
+    // thread's are exact.
+    ObjectPoolStats stats() const {
+        return m_core->stats();
+    }
+
+private:
+    struct Batch {
+        std::vector<T*> objects;
+        Batch* next = nullptr;
+    };
+
+    struct Counters {
+        size_t acquired = 0;
+        size_t local_hits = 0;
+        size_t global_hits = 0;
+        size_t allocated = 0;
+    };
+
+    struct LocalCache {
+        std::weak_ptr<Core> core;
+        std::vector<T*> objects;
+        Counters counters;
+
+        ~LocalCache() {
+            if (auto owner = core.lock()) {
+                owner->give_back(objects);
+                owner->merge(counters);
+            } else {
+                for (T* object : objects) {
+                    delete object;
+                }
+            }
+        }
+    };
+
+    // Per-thread caches of every live pool of this type, keyed by pool id so
+    // that an id is never shared by two pools.
+    struct LocalCaches {
+        std::unordered_map<std::uint64_t, LocalCache> caches;
+        std::uint64_t lastId = 0;
+        LocalCache* last = nullptr;
+
+        LocalCache& get(Core& core) {
+            if (lastId == core.id()) {
+                return *last;
+            }
+            auto it = caches.find(core.id());
+            if (it == caches.end()) {
+                std::erase_if(caches, [](const auto& entry) { return entry.second.core.expired(); });
+                it = caches.try_emplace(core.id()).first;
+                it->second.core = core.weak_from_this();
+            }
+            lastId = core.id();
+            last = &it->second;
+            return *last;
+        }
+
+        void forget(std::uint64_t id) {
+            if (lastId == id) {
+                lastId = 0;
+                last = nullptr;
+            }
+            caches.erase(id);
+        }
+    };
+
+    static LocalCaches& local_caches() {
+        thread_local LocalCaches caches;
+        return caches;
+    }
+
+    class Core : public std::enable_shared_from_this<Core> {
+    public:
+        Core(Factory factory, Recycler recycler, Options options)
+            : m_factory(std::move(factory)), m_recycler(std::move(recycler)),
+              m_cacheSize(std::max<size_t>(options.thread_cache_size, 2)), m_maxCached(options.max_cached),
+              m_id(next_id()), m_top(nullptr), m_cached(0) {}
+
+        // Runs once no thread can reach the pool any more, so the stack
+        // can be walked without protection.
+        ~Core() {
+            Batch* batch = m_top.load(std::memory_order_acquire);
+            while (batch) {
+                Batch* next = batch->next;
+                for (T* object : batch->objects) {
+                    delete object;
+                }
+                delete batch;
+                batch = next;
+            }
+        }
+
+        std::uint64_t id() const { return m_id; }
+
+        T* acquire() {
+            LocalCache& cache = local_caches().get(*this);
+            cache.counters.acquired++;
+            if (!cache.objects.empty()) {
+                cache.counters.local_hits++;
+                T* object = cache.objects.back();
+                cache.objects.pop_back();
+                return object;
+            }
+            if (pop_batch(cache.objects)) {
+                cache.counters.global_hits++;
+                merge(cache.counters);
+                T* object = cache.objects.back();
+                cache.objects.pop_back();
+                return object;
+            }
+            cache.counters.allocated++;
+            merge(cache.counters);
+            return m_factory().release();
+        }
+
+        void release(T* object) {
+            if (m_recycler) {
+                m_recycler(*object);
+            }
+            LocalCache& cache = local_caches().get(*this);
+            cache.objects.push_back(object);
+            if (cache.objects.size() >= m_cacheSize) {
+                // Keep half locally so alternating acquire/release does not
+                // bounce batches through the shared stack.
+                std::vector<T*> spill(cache.objects.begin() + m_cacheSize / 2, cache.objects.end());
+                cache.objects.resize(m_cacheSize / 2);
+                give_back(spill);
+            }
+        }
+
+        void give_back(std::vector<T*>& objects) {
+            if (objects.empty()) {
+                return;
+            }
+            if (m_cached.load(std::memory_order_relaxed) >= m_maxCached) {
+                for (T* object : objects) {
+                    delete object;
+                }
+                objects.clear();
+                return;
+            }
+            auto* batch = new Batch();
+            batch->objects.swap(objects);
+            m_cached.fetch_add(batch->objects.size(), std::memory_order_relaxed);
+            push_batch(batch);
+        }
+
+        void flush_local() {
+            LocalCache& cache = local_caches().get(*this);
+            give_back(cache.objects);
+            merge(cache.counters);
+        }
+
+        void trim(size_t keep) {
+            std::vector<T*> objects;
+            while (m_cached.load(std::memory_order_relaxed) > keep && pop_batch(objects)) {
+                for (T* object : objects) {
+                    delete object;
+                }
+                objects.clear();
+            }
+        }
+
+        void merge(Counters& counters) {
+            m_acquired.fetch_add(counters.acquired, std::memory_order_relaxed);
+            m_localHits.fetch_add(counters.local_hits, std::memory_order_relaxed);
+            m_globalHits.fetch_add(counters.global_hits, std::memory_order_relaxed);
+            m_allocated.fetch_add(counters.allocated, std::memory_order_relaxed);
+            counters = Counters();
+        }
+
+        ObjectPoolStats stats() {
+            const Counters& local = local_caches().get(*this).counters;
+            ObjectPoolStats result;
+            result.acquired = m_acquired.load(std::memory_order_relaxed) + local.acquired;
+            result.local_hits = m_localHits.load(std::memory_order_relaxed) + local.local_hits;
+            result.global_hits = m_globalHits.load(std::memory_order_relaxed) + local.global_hits;
+            result.allocated = m_allocated.load(std::memory_order_relaxed) + local.allocated;
+            result.cached = m_cached.load(std::memory_order_relaxed);
+            return result;
+        }
+
+    private:
+        static std::uint64_t next_id() {
+            static std::atomic<std::uint64_t> id{0};
+            return ++id;
+        }
+
+        void push_batch(Batch* batch) {
+            Batch* top = m_top.load(std::memory_order_relaxed);
+            do {
+                batch->next = top;
+            } while (!m_top.compare_exchange_weak(top, batch, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // Moves the objects of the top batch into objects, which must be
+        // empty.
+        bool pop_batch(std::vector<T*>& objects) {
+            HazardPointer hp;
+            Batch* top;
+            while (true) {
+                top = hp.protect(m_top);
+                if (top == nullptr) {
+                    return false;
+                }
+                if (m_top.compare_exchange_weak(top, top->next, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            hp.reset();
+            objects.swap(top->objects);
+            m_cached.fetch_sub(objects.size(), std::memory_order_relaxed);
+            retire_hazard_pointer(top);
+            return true;
+        }
+
+        Factory m_factory;
+        Recycler m_recycler;
+        const size_t m_cacheSize;
+        const size_t m_maxCached;
+        const std::uint64_t m_id;
+        std::atomic<Batch*> m_top;
+        std::atomic<size_t> m_cached;
+        std::atomic<size_t> m_acquired{0};
+        std::atomic<size_t> m_localHits{0};
+        std::atomic<size_t> m_globalHits{0};
+        std::atomic<size_t> m_allocated{0};
+    };
+
+    std::shared_ptr<Core> m_core;
+};
+
+// Scratch byte buffers in power-of-two size classes, one ObjectPool per
+// class. Requests above max_size are allocated exactly and not cached.
+class BufferPool {
+public:
+    using Buffer = std::vector<std::byte>;
+    using Handle = ObjectPool<Buffer>::Handle;
+
+    explicit BufferPool(size_t min_size = 256, size_t max_size = 4 * 1024 * 1024,
+                        ObjectPool<Buffer>::Options options = ObjectPool<Buffer>::Options())
+        : m_minSize(std::bit_ceil(std::max<size_t>(min_size, 1))), m_maxSize(max_size) {
+        // Callers may resize or clear a buffer, so the recycler restores the
+        // class size before the buffer is handed out again.
+        for (size_t size = m_minSize; size <= m_maxSize; size *= 2) {
+            m_classes.push_back(std::make_unique<ObjectPool<Buffer>>(
+                [size]() { return std::make_unique<Buffer>(size); },
+                [size](Buffer& buffer) { buffer.resize(size); }, options));
+        }
+    }
+
+    // The buffer holds at least size bytes; its contents are unspecified.
+    Handle acquire(size_t size) {
+        size_t index = class_index(size);
+        if (index >= m_classes.size()) {
+            return ObjectPool<Buffer>::unpooled(std::make_unique<Buffer>(size));
+        }
+        return m_classes[index]->acquire();
+    }
+
+    void trim(size_t keep_per_class = 0) {
+        for (auto& pool : m_classes) {
+            pool->trim(keep_per_class);
+        }
+    }
+
+    ObjectPoolStats stats() const {
+        ObjectPoolStats total;
+        for (const auto& pool : m_classes) {
+            total += pool->stats();
+        }
+        return total;
+    }
+
+    size_t size_classes() const {
+        return m_classes.size();
+    }
+
+private:
+    size_t class_index(size_t size) const {
+        if (size <= m_minSize) {
+            return 0;
+        }
+        return std::bit_width(std::bit_ceil(size) / m_minSize) - 1;
+    }
+
+    const size_t m_minSize;
+    const size_t m_maxSize;
+    std::vector<std::unique_ptr<ObjectPool<Buffer>>> m_classes;
+};
@@ -0,0 +1,142 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "CancellationToken.h"
+#include "TimerQueue.h"
+#include "WaiterList.h"
+
+// Token bucket allowing rate_per_second acquisitions on average and bursts
+// of up to burst. Waiters are queued and resumed from the TimerQueue thread
+// as tokens accrue, so no thread sleeps on their behalf. The TimerQueue
+// must outlive the limiter's pending timers; a destroyed limiter simply
+// ignores them. rate_per_second must be positive and burst at least 1.
+class RateLimiter {
+public:
+    using Continuation = std::function<void()>;
+    using Clock = TimerQueue::Clock;
+
+    RateLimiter(TimerQueue& timers, double rate_per_second, double burst)
+        : m_state(std::make_shared<State>(timers, rate_per_second, burst)) {
+        // Written to reject NaN as well.
+        if (!(rate_per_second > 0.0)) {
+            throw std::invalid_argument("RateLimiter: rate_per_second must be positive");
+        }
+        if (!(burst >= 1.0)) {
+            throw std::invalid_argument("RateLimiter: burst must be at least 1");
+        }
+    }
+
+    RateLimiter(const RateLimiter&) = delete;
+    RateLimiter& operator=(const RateLimiter&) = delete;
+
+    bool try_acquire() {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->refill(Clock::now());
+        if (m_state->tokens < 1.0 || !m_state->waiters.empty()) {
+            return false;
+        }
+        m_state->tokens -= 1.0;
+        return true;
+    }
+
+    // Runs continuation inline if a token is available, otherwise from the
+    // timer thread once it is. A cancelled waiter consumes no token.
+    void acquire(Continuation continuation, const CancellationToken& token = CancellationToken()) {
+        if (token.is_cancellation_requested()) {
+            return;
+        }
+        detail::WaiterList::Id id = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            m_state->refill(Clock::now());
+            if (m_state->tokens >= 1.0 && m_state->waiters.empty()) {
+                m_state->tokens -= 1.0;
+            } else {
+                id = m_state->waiters.push(std::move(continuation));
+                State::arm_timer(m_state);
+            }
+        }
+        if (id == 0) {
+            continuation();
+            return;
+        }
+        m_state->waiters.watch(m_state->mutex, id, token);
+    }
+
+    // Tokens are spent, not returned; present so RateLimiter can be used
+    // wherever an AsyncSemaphore is.
+    void release() {}
+
+    size_t waiting() const {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        return m_state->waiters.size();
+    }
+
+private:
+    struct State {
+        State(TimerQueue& timers, double rate, double burst)
+            : timers(timers), rate(rate), burst(burst), tokens(burst), last(Clock::now()), timerArmed(false) {}
+
+        // Called with mutex held.
+        void refill(Clock::time_point now) {
+            std::chrono::duration<double> elapsed = now - last;
+            tokens = std::min(burst, tokens + elapsed.count() * rate);
+            last = now;
+        }
+
+        // Called with mutex held. The timer holds only a weak reference, so
+        // a destroyed limiter does not keep its state alive.
+        static void arm_timer(const std::shared_ptr<State>& state) {
+            if (state->timerArmed || state->waiters.empty()) {
+                return;
+            }
+            state->timerArmed = true;
+            std::chrono::duration<double> wait((1.0 - state->tokens) / state->rate);
+            std::weak_ptr<State> weak = state;
+            state->timers.schedule_after(std::chrono::duration_cast<Clock::duration>(wait), [weak]() {
+                if (auto locked = weak.lock()) {
+                    on_timer(locked);
+                }
+            });
+        }
+
+        static void on_timer(const std::shared_ptr<State>& state) {
+            std::vector<detail::Waiter> resumed;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->timerArmed = false;
+                state->refill(Clock::now());
+                while (state->tokens >= 1.0) {
+                    std::optional<detail::Waiter> waiter = state->waiters.pop();
+                    if (!waiter) {
+                        break;
+                    }
+                    state->tokens -= 1.0;
+                    resumed.push_back(std::move(*waiter));
+                }
+                arm_timer(state);
+            }
+            for (auto& waiter : resumed) {
+                waiter.resume();
+            }
+        }
+
+        TimerQueue& timers;
+        const double rate;
+        const double burst;
+        double tokens;
+        Clock::time_point last;
+        bool timerArmed;
+        std::mutex mutex;
+        detail::WaiterList waiters;
+    };
+
+    std::shared_ptr<State> m_state;
+};
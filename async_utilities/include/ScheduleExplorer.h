@@ -0,0 +1,281 @@
+#pragma once
+#ifndef ASYNC_SCHEDULE_HOOKS
+#error "ScheduleExplorer.h needs a build with ASYNC_SCHEDULE_HOOKS defined"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SchedulePoint.h"
+
+// Runs a set of threads one at a time, switching between them only at
+// ASYNC_SCHEDULE_POINT()s, with every switch chosen by a PRNG seeded with
+// seed. The same seed replays the same interleaving as long as the threads
+// interact only through instrumented code and never block on each other.
+// Interleavings are explored under sequential consistency; reorderings
+// allowed by weaker memory orders are not.
+class ControlledScheduler : public detail::ScheduleHook {
+public:
+    explicit ControlledScheduler(std::uint64_t seed)
+        : m_rng(seed), m_current(0), m_remaining(0), m_switches(0),
+          m_previous(detail::schedule_hook().exchange(this)) {}
+
+    ~ControlledScheduler() override {
+        detail::schedule_hook().store(m_previous);
+    }
+
+    ControlledScheduler(const ControlledScheduler&) = delete;
+    ControlledScheduler& operator=(const ControlledScheduler&) = delete;
+
+    // Runs each body on its own thread and returns once all have finished.
+    // The first exception thrown by a body is rethrown here.
+    void run(std::vector<std::function<void()>> bodies) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_alive.assign(bodies.size(), true);
+            m_remaining = bodies.size();
+            m_current = pick_locked();
+        }
+
+        std::exception_ptr failure;
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < bodies.size(); ++i) {
+            threads.emplace_back([this, i, &bodies, &failure]() {
+                managed_index() = i;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cv.wait(lock, [this, i]() { return m_current == i; });
+                }
+                try {
+                    bodies[i]();
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                }
+                managed_index() = Unmanaged;
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_alive[i] = false;
+                if (--m_remaining > 0) {
+                    m_current = pick_locked();
+                }
+                m_cv.notify_all();
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    // Number of context switches taken so far.
+    size_t switches() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_switches;
+    }
+
+    void schedule_point() override {
+        size_t me = managed_index();
+        if (me == Unmanaged) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        size_t next = pick_locked();
+        if (next == me) {
+            return;
+        }
+        m_current = next;
+        m_switches++;
+        m_cv.notify_all();
+        m_cv.wait(lock, [this, me]() { return m_current == me; });
+    }
+
+private:
+    static constexpr size_t Unmanaged = std::numeric_limits<size_t>::max();
+
+    static size_t& managed_index() {
+        thread_local size_t index = Unmanaged;
+        return index;
+    }
+
+    // Called with m_mutex held and at least one thread alive.
+    size_t pick_locked() {
+        size_t choice = std::uniform_int_distribution<size_t>(0, m_remaining - 1)(m_rng);
+        for (size_t i = 0; i < m_alive.size(); ++i) {
+            if (m_alive[i] && choice-- == 0) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::mt19937_64 m_rng;
+    std::vector<bool> m_alive;
+    size_t m_current;
+    size_t m_remaining;
+    size_t m_switches;
+    detail::ScheduleHook* m_previous;
+};
+
+// Seeded yield injection for code that runs on threads the test does not
+// own or that blocks, such as ThreadPool workers. Each thread draws from
+// its own PRNG, derived from seed and the order in which threads first
+// reach a schedule point, and yields or sleeps briefly at some points. The
+// OS still schedules the threads, so a seed makes an interleaving likely to
+// recur rather than certain. Must outlive every thread that can reach a
+// schedule point while it is installed.
+class RandomYieldScheduler : public detail::ScheduleHook {
+public:
+    explicit RandomYieldScheduler(std::uint64_t seed, unsigned yield_one_in = 4)
+        : m_seed(seed), m_yieldOneIn(std::max(1u, yield_one_in)), m_nextThread(0),
+          m_previous(detail::schedule_hook().exchange(this)) {}
+
+    ~RandomYieldScheduler() override {
+        detail::schedule_hook().store(m_previous);
+    }
+
+    RandomYieldScheduler(const RandomYieldScheduler&) = delete;
+    RandomYieldScheduler& operator=(const RandomYieldScheduler&) = delete;
+
+    void schedule_point() override {
+        struct ThreadState {
+            const RandomYieldScheduler* owner = nullptr;
+            std::mt19937_64 rng;
+        };
+        thread_local ThreadState state;
+        if (state.owner != this) {
+            state.owner = this;
+            state.rng.seed(m_seed * 0x9E3779B97F4A7C15ull + m_nextThread.fetch_add(1));
+        }
+        std::uint64_t draw = state.rng();
+        if (draw % m_yieldOneIn != 0) {
+            return;
+        }
+        if ((draw >> 32) % 16 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds((draw >> 40) % 50));
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    const std::uint64_t m_seed;
+    const unsigned m_yieldOneIn;
+    std::atomic<std::uint64_t> m_nextThread;
+    detail::ScheduleHook* m_previous;
+};
+
+// Calls run(seed) for seeds 1..runs and returns the first seed for which it
+// returned false. Setting ASYNC_SCHEDULE_SEED replays that seed alone.
+template<typename Run>
+std::optional<std::uint64_t> explore_seeds(std::uint64_t runs, Run run) {
+    if (const char* replay = std::getenv("ASYNC_SCHEDULE_SEED")) {
+        std::uint64_t seed = std::stoull(replay);
+        return run(seed) ? std::nullopt : std::optional<std::uint64_t>(seed);
+    }
+    for (std::uint64_t seed = 1; seed <= runs; ++seed) {
+        if (!run(seed)) {
+            return seed;
+        }
+    }
+    return std::nullopt;
+}
+
+// Concurrent history of operations on one object. Each entry spans the
+// logical times at which the call started and returned.
+template<typename Op>
+class History {
+public:
+    struct Entry {
+        Op op;
+        size_t invoked;
+        size_t returned;
+    };
+
+    History() : m_clock(0) {}
+
+    // call(op) performs the operation and records its outcome in op.
+    template<typename Call>
+    void record(Op op, Call&& call) {
+        size_t invoked = m_clock.fetch_add(1, std::memory_order_seq_cst);
+        call(op);
+        size_t returned = m_clock.fetch_add(1, std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.push_back({std::move(op), invoked, returned});
+    }
+
+    std::vector<Entry> entries() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries;
+    }
+
+private:
+    std::atomic<size_t> m_clock;
+    mutable std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+};
+
+namespace detail {
+
+template<typename Entry, typename Model>
+bool linearize(const std::vector<Entry>& entries, std::vector<bool>& done, size_t remaining, const Model& model) {
+    if (remaining == 0) {
+        return true;
+    }
+    size_t first_return = std::numeric_limits<size_t>::max();
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (!done[i]) {
+            first_return = std::min(first_return, entries[i].returned);
+        }
+    }
+    // Any pending call that started before the earliest pending return may
+    // take effect next.
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (done[i] || entries[i].invoked > first_return) {
+            continue;
+        }
+        Model next = model;
+        if (!next.apply(entries[i].op)) {
+            continue;
+        }
+        done[i] = true;
+        if (linearize(entries, done, remaining - 1, next)) {
+            return true;
+        }
+        done[i] = false;
+    }
+    return false;
+}
+
+} // namespace detail
+
+// Checks that the history can be explained by applying its operations one
+// at a time, each somewhere between its invocation and return, to a
+// sequential model (Wing & Gong). Model is copyable and has
+// bool apply(const Op&), which applies the operation and reports whether
+// the recorded outcome matches. The search is exponential, so keep
+// histories to a dozen or so operations.
+template<typename Op, typename Model>
+bool is_linearizable(const History<Op>& history, const Model& initial) {
+    auto entries = history.entries();
+    std::vector<bool> done(entries.size(), false);
+    return detail::linearize(entries, done, entries.size(), initial);
+}
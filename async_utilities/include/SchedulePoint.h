@@ -0,0 +1,33 @@
+#pragma once
+
+// Yield points for schedule exploration (see ScheduleExplorer.h). Builds that
+// define ASYNC_SCHEDULE_HOOKS call the installed hook at every
+// ASYNC_SCHEDULE_POINT(); other builds compile the points away.
+#ifdef ASYNC_SCHEDULE_HOOKS
+#include <atomic>
+
+namespace detail {
+
+class ScheduleHook {
+public:
+    virtual ~ScheduleHook() = default;
+    virtual void schedule_point() = 0;
+};
+
+inline std::atomic<ScheduleHook*>& schedule_hook() {
+    static std::atomic<ScheduleHook*> hook{nullptr};
+    return hook;
+}
+
+inline void schedule_point() {
+    if (ScheduleHook* hook = schedule_hook().load(std::memory_order_acquire)) {
+        hook->schedule_point();
+    }
+}
+
+} // namespace detail
+
+#define ASYNC_SCHEDULE_POINT() ::detail::schedule_point()
+#else
+#define ASYNC_SCHEDULE_POINT() static_cast<void>(0)
+#endif
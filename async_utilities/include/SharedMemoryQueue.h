@@ -0,0 +1,605 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Records must be plain data: they are copied byte for byte into memory
+// mapped by other processes, so they must not hold pointers either.
+template<typename T>
+concept SharedMemoryRecord = std::is_trivially_copyable_v<T> && std::is_trivially_default_constructible_v<T>;
+
+namespace detail {
+
+inline std::atomic<pid_t>& cached_pid() {
+    static std::atomic<pid_t> pid{0};
+    return pid;
+}
+
+// getpid() is a system call in current glibc; the queue needs the pid on
+// every claim, so it is cached and refreshed in forked children.
+inline pid_t current_pid() {
+    static const bool registered = []() {
+        cached_pid().store(::getpid(), std::memory_order_relaxed);
+        pthread_atfork(nullptr, nullptr, []() { cached_pid().store(::getpid(), std::memory_order_relaxed); });
+        return true;
+    }();
+    (void)registered;
+    return cached_pid().load(std::memory_order_relaxed);
+}
+
+inline bool is_process_alive(pid_t pid) {
+    return ::kill(pid, 0) == 0 || errno == EPERM;
+}
+
+// EventCount for waiters in several processes. A waiter counter would be
+// left raised by a process killed while parked, and every notify would
+// then make a futex call. Instead each parked waiter holds one of
+// MaxWaiters entries, recording its pid, plus a bit in a mask that
+// notifiers check. When a wakeup finds nobody, the notifier frees the
+// entries of processes that have died, at most once per PruneInterval
+// because a waiter that was just woken also still holds its entry.
+class SharedEventCount {
+public:
+    static constexpr unsigned MaxWaiters = 64;
+
+    struct Key {
+        std::uint32_t epoch;
+        unsigned entry;
+    };
+
+    static constexpr std::chrono::milliseconds PruneInterval{10};
+
+    SharedEventCount() : m_epoch(0), m_parked(0), m_nextPrune(0), m_pids{} {}
+
+    // Returns nothing if every entry is taken; the caller should poll.
+    std::optional<Key> prepare_wait(pid_t self) {
+        for (unsigned entry = 0; entry < MaxWaiters; ++entry) {
+            std::uint32_t expected = 0;
+            if (m_pids[entry].compare_exchange_strong(expected, static_cast<std::uint32_t>(self),
+                                                      std::memory_order_seq_cst)) {
+                m_parked.fetch_or(bit(entry), std::memory_order_seq_cst);
+                return Key{m_epoch.load(std::memory_order_seq_cst), entry};
+            }
+        }
+        return std::nullopt;
+    }
+
+    void cancel_wait(Key key) {
+        unpark(key.entry);
+    }
+
+    // Returns false if it timed out without being notified.
+    bool wait_for(Key key, std::chrono::nanoseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        bool notified = true;
+        while (m_epoch.load(std::memory_order_acquire) == key.epoch) {
+            auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - std::chrono::steady_clock::now());
+            if (left <= std::chrono::nanoseconds::zero()) {
+                notified = false;
+                break;
+            }
+            timespec relative{};
+            relative.tv_sec = static_cast<time_t>(left.count() / 1000000000);
+            relative.tv_nsec = static_cast<long>(left.count() % 1000000000);
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_epoch), FUTEX_WAIT, key.epoch, &relative, nullptr, 0);
+        }
+        unpark(key.entry);
+        return notified;
+    }
+
+    void notify_one() {
+        notify(false);
+    }
+
+    void notify_all() {
+        notify(true);
+    }
+
+    unsigned waiting() const {
+        return static_cast<unsigned>(std::popcount(m_parked.load(std::memory_order_acquire)));
+    }
+
+private:
+    static std::uint64_t bit(unsigned entry) {
+        return std::uint64_t(1) << entry;
+    }
+
+    void unpark(unsigned entry) {
+        m_parked.fetch_and(~bit(entry), std::memory_order_seq_cst);
+        m_pids[entry].store(0, std::memory_order_release);
+    }
+
+    void notify(bool all) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_parked.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        m_epoch.fetch_add(1, std::memory_order_release);
+        if (syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&m_epoch), FUTEX_WAKE, all ? INT_MAX : 1,
+                    nullptr, nullptr, 0) != 0) {
+            return;
+        }
+        // CLOCK_MONOTONIC, so the times agree across processes.
+        auto now = std::chrono::steady_clock::now();
+        std::int64_t next = m_nextPrune.load(std::memory_order_relaxed);
+        if (now.time_since_epoch().count() >= next &&
+            m_nextPrune.compare_exchange_strong(next, (now + PruneInterval).time_since_epoch().count(),
+                                                std::memory_order_relaxed)) {
+            prune();
+        }
+    }
+
+    // An entry is only cleared by the process that holds it, so a dead
+    // holder's entry is first taken over under our own pid; if we die too,
+    // the next prune() takes it from us.
+    void prune() {
+        const auto self = static_cast<std::uint32_t>(current_pid());
+        for (unsigned entry = 0; entry < MaxWaiters; ++entry) {
+            std::uint32_t holder = m_pids[entry].load(std::memory_order_acquire);
+            if (holder != 0 && holder != self && !is_process_alive(static_cast<pid_t>(holder)) &&
+                m_pids[entry].compare_exchange_strong(holder, self, std::memory_order_acq_rel)) {
+                unpark(entry);
+            }
+        }
+    }
+
+    std::atomic<std::uint32_t> m_epoch;
+    std::atomic<std::uint64_t> m_parked;
+    std::atomic<std::int64_t> m_nextPrune;
+    std::atomic<std::uint32_t> m_pids[MaxWaiters];
+
+    static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+                  "futex word must be a plain 32-bit integer");
+};
+
+// Lives at the start of the mapping. Nothing in shared memory is a pointer:
+// each process maps the segment at its own address, so the slots are found
+// through slots_offset from the start of its own mapping.
+struct SharedMemoryQueueHeader {
+    static constexpr std::uint64_t Magic = 0x41535953514d4853;  // "SHMQSYSA"
+    static constexpr std::uint32_t Version = 2;
+
+    std::atomic<std::uint64_t> magic;  // written last by the creator
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint64_t capacity;
+    std::uint64_t slots_offset;
+    std::atomic<std::uint64_t> abandoned;
+    std::atomic<bool> stopped;
+
+    alignas(64) std::atomic<std::uint64_t> enqueue_pos;
+    alignas(64) std::atomic<std::uint64_t> dequeue_pos;
+    alignas(64) SharedEventCount items;
+    alignas(64) SharedEventCount space;
+
+    SharedMemoryQueueHeader(std::uint32_t record_size, std::uint64_t capacity, std::uint64_t slots_offset)
+        : magic(0), version(Version), record_size(record_size), capacity(capacity), slots_offset(slots_offset),
+          abandoned(0), stopped(false), enqueue_pos(0), dequeue_pos(0) {}
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+              "shared memory atomics must be address-free");
+
+} // namespace detail
+
+// Linux only. A bounded multi-producer, multi-consumer queue of plain
+// records in a named POSIX shared memory segment, for handing work to
+// another process. One process create()s the queue, the others open() it
+// by name.
+//
+// Each slot carries one state word holding its turn (the position it is
+// waiting for) and the pid of the process currently writing or reading it.
+// try_emplace() and try_consume() work directly on the slot, so a record is
+// never copied through the kernel. The fast path is a few atomics; the
+// futex is only touched when a peer is parked in push() or pop(). At most
+// SharedEventCount::MaxWaiters callers park on each side at a time; any
+// beyond that poll instead.
+//
+// If a peer dies while it holds a slot, the slot would block the queue
+// forever. When a claimed slot stands between a caller and a record (or a
+// free slot), the caller checks whether the claiming process still exists
+// and, if not, skips the slot; the record in it is lost and counted in
+// abandoned(). A dead peer that has not been reaped yet still counts as
+// alive.
+template<SharedMemoryRecord T>
+class SharedMemoryQueue {
+public:
+    // Creates the segment name (e.g. "/jobs") with room for capacity
+    // records, rounded up to a power of two. Fails if it already exists;
+    // remove a stale one with unlink(). The creating object unlinks the
+    // name when it is destroyed; processes that have the queue open keep
+    // using it.
+    static SharedMemoryQueue create(const std::string& name, size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded *= 2;
+        }
+        size_t bytes = slots_offset() + rounded * sizeof(Slot);
+
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "SharedMemoryQueue: shm_open " + name);
+        }
+        if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            int error = errno;
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::system_error(error, std::generic_category(), "SharedMemoryQueue: ftruncate " + name);
+        }
+        void* base = map(fd, bytes);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            int error = errno;
+            ::shm_unlink(name.c_str());
+            throw std::system_error(error, std::generic_category(), "SharedMemoryQueue: mmap " + name);
+        }
+
+        auto* header = new (base) detail::SharedMemoryQueueHeader(sizeof(T), rounded, slots_offset());
+        auto* slots = reinterpret_cast<Slot*>(static_cast<std::byte*>(base) + slots_offset());
+        for (size_t i = 0; i < rounded; ++i) {
+            new (&slots[i]) Slot(i);
+        }
+        header->magic.store(detail::SharedMemoryQueueHeader::Magic, std::memory_order_release);
+        return SharedMemoryQueue(base, bytes, name);
+    }
+
+    // Maps a queue another process created. Throws if it does not exist or
+    // holds a different record type.
+    static SharedMemoryQueue open(const std::string& name) {
+        int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "SharedMemoryQueue: shm_open " + name);
+        }
+        struct stat info{};
+        if (::fstat(fd, &info) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "SharedMemoryQueue: fstat " + name);
+        }
+        auto bytes = static_cast<size_t>(info.st_size);
+        if (bytes < slots_offset()) {
+            ::close(fd);
+            throw std::runtime_error("SharedMemoryQueue: " + name + " is not initialised");
+        }
+        void* base = map(fd, bytes);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "SharedMemoryQueue: mmap " + name);
+        }
+
+        SharedMemoryQueue queue(base, bytes, std::string());
+        const auto& header = *queue.m_header;
+        if (header.magic.load(std::memory_order_acquire) != detail::SharedMemoryQueueHeader::Magic ||
+            header.version != detail::SharedMemoryQueueHeader::Version) {
+            throw std::runtime_error("SharedMemoryQueue: " + name + " is not initialised");
+        }
+        if (header.record_size != sizeof(T) || header.slots_offset != slots_offset() ||
+            header.slots_offset + header.capacity * sizeof(Slot) > bytes) {
+            throw std::runtime_error("SharedMemoryQueue: " + name + " holds a different record type");
+        }
+        return queue;
+    }
+
+    static void unlink(const std::string& name) {
+        ::shm_unlink(name.c_str());
+    }
+
+    SharedMemoryQueue(SharedMemoryQueue&& other) noexcept
+        : m_base(std::exchange(other.m_base, nullptr)), m_bytes(other.m_bytes),
+          m_header(other.m_header), m_slots(other.m_slots), m_mask(other.m_mask),
+          m_ownedName(std::move(other.m_ownedName)) {
+        other.m_ownedName.clear();
+    }
+
+    SharedMemoryQueue& operator=(SharedMemoryQueue&&) = delete;
+    SharedMemoryQueue(const SharedMemoryQueue&) = delete;
+    SharedMemoryQueue& operator=(const SharedMemoryQueue&) = delete;
+
+    ~SharedMemoryQueue() {
+        if (m_base) {
+            ::munmap(m_base, m_bytes);
+        }
+        if (!m_ownedName.empty()) {
+            ::shm_unlink(m_ownedName.c_str());
+        }
+    }
+
+    // Claims the next free slot and lets fill write the record in place.
+    // Returns false if the queue is full. fill must not throw.
+    template<typename Fill>
+    bool try_emplace(Fill&& fill) {
+        const std::uint32_t self = static_cast<std::uint32_t>(detail::current_pid());
+        std::uint64_t pos = m_header->enqueue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = m_slots[pos & m_mask];
+            std::uint64_t state = slot.state.load(std::memory_order_acquire);
+            auto diff = static_cast<std::int32_t>(turn_of(state) - static_cast<std::uint32_t>(pos));
+            if (diff == 0 && owner_of(state) == NoOwner) {
+                if (slot.state.compare_exchange_weak(state, make_state(turn_of(state), self),
+                                                     std::memory_order_acquire, std::memory_order_relaxed)) {
+                    advance(m_header->enqueue_pos, pos);
+                    fill(slot.record);
+                    slot.state.store(make_state(static_cast<std::uint32_t>(pos + 1), NoOwner),
+                                     std::memory_order_release);
+                    m_header->items.notify_one();
+                    return true;
+                }
+            } else if (diff >= 0) {
+                // Already claimed for pos; its claimer may have died before
+                // moving enqueue_pos on, so help.
+                advance(m_header->enqueue_pos, pos);
+                pos = m_header->enqueue_pos.load(std::memory_order_relaxed);
+            } else {
+                // The previous record in this slot has not been consumed.
+                std::uint64_t current = m_header->enqueue_pos.load(std::memory_order_relaxed);
+                if (current != pos) {
+                    pos = current;
+                } else if (!recover(slot, state)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    bool try_push(const T& record) {
+        return try_emplace([&record](T& slot) { slot = record; });
+    }
+
+    // Claims the oldest record and passes it to consume in place. Returns
+    // false if there is none ready. consume must not throw.
+    template<typename Consume>
+    bool try_consume(Consume&& consume) {
+        const std::uint32_t self = static_cast<std::uint32_t>(detail::current_pid()) | ReaderBit;
+        std::uint64_t pos = m_header->dequeue_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = m_slots[pos & m_mask];
+            std::uint64_t state = slot.state.load(std::memory_order_acquire);
+            auto full_turn = static_cast<std::uint32_t>(pos + 1);
+            auto diff = static_cast<std::int32_t>(turn_of(state) - full_turn);
+            if (diff == 0 && owner_of(state) == NoOwner) {
+                if (slot.state.compare_exchange_weak(state, make_state(full_turn, self),
+                                                     std::memory_order_acquire, std::memory_order_relaxed)) {
+                    advance(m_header->dequeue_pos, pos);
+                    consume(std::as_const(slot.record));
+                    release(slot, pos);
+                    return true;
+                }
+            } else if (diff == 0 && owner_of(state) == Abandoned) {
+                // A writer died while filling this slot; skip it.
+                if (slot.state.compare_exchange_strong(state, free_state(pos),
+                                                       std::memory_order_relaxed, std::memory_order_relaxed)) {
+                    advance(m_header->dequeue_pos, pos);
+                    m_header->space.notify_one();
+                }
+                pos = m_header->dequeue_pos.load(std::memory_order_relaxed);
+            } else if (diff >= 0) {
+                advance(m_header->dequeue_pos, pos);
+                pos = m_header->dequeue_pos.load(std::memory_order_relaxed);
+            } else {
+                // Not written yet, or the previous lap is still being read.
+                std::uint64_t current = m_header->dequeue_pos.load(std::memory_order_relaxed);
+                if (current != pos) {
+                    pos = current;
+                } else if (!recover(slot, state)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    bool try_pop(T& record) {
+        return try_consume([&record](const T& slot) { record = slot; });
+    }
+
+    // Blocks until there is room. Returns false if the queue was stopped.
+    bool push(const T& record) {
+        return push_for(record, std::chrono::nanoseconds::max());
+    }
+
+    bool push_for(const T& record, std::chrono::nanoseconds timeout) {
+        return wait_until_done(m_header->space, timeout, [this, &record]() {
+            if (m_header->stopped.load(std::memory_order_acquire)) {
+                return std::optional<bool>(false);
+            }
+            if (try_push(record)) {
+                return std::optional<bool>(true);
+            }
+            return std::optional<bool>();
+        });
+    }
+
+    // Blocks until a record is available. Returns false once the queue has
+    // been stopped and drained.
+    bool pop(T& record) {
+        return pop_for(record, std::chrono::nanoseconds::max());
+    }
+
+    bool pop_for(T& record, std::chrono::nanoseconds timeout) {
+        return wait_until_done(m_header->items, timeout, [this, &record]() {
+            if (try_pop(record)) {
+                return std::optional<bool>(true);
+            }
+            if (m_header->stopped.load(std::memory_order_seq_cst)) {
+                return std::optional<bool>(try_pop(record));
+            }
+            return std::optional<bool>();
+        });
+    }
+
+    // Seen by every process: pushes fail and pops return false once the
+    // queue is drained.
+    void stop() {
+        m_header->stopped.store(true, std::memory_order_seq_cst);
+        m_header->items.notify_all();
+        m_header->space.notify_all();
+    }
+
+    bool is_stopped() const {
+        return m_header->stopped.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return static_cast<size_t>(m_mask + 1);
+    }
+
+    // Approximate while other processes are pushing or popping.
+    size_t size() const {
+        std::uint64_t head = m_header->dequeue_pos.load(std::memory_order_acquire);
+        std::uint64_t tail = m_header->enqueue_pos.load(std::memory_order_acquire);
+        return tail > head ? static_cast<size_t>(tail - head) : 0;
+    }
+
+    // Callers parked in push() or pop(), in any process.
+    unsigned waiting() const {
+        return m_header->items.waiting() + m_header->space.waiting();
+    }
+
+    // Records lost because a peer died while writing or reading them.
+    std::uint64_t abandoned() const {
+        return m_header->abandoned.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Low half of a slot state: 0, the pid of the writer, the pid of the
+    // reader with ReaderBit set, or Abandoned. Linux pids fit in 22 bits.
+    static constexpr std::uint32_t NoOwner = 0;
+    static constexpr std::uint32_t ReaderBit = 1u << 31;
+    static constexpr std::uint32_t Abandoned = ReaderBit - 1;
+
+    // Parked callers re-check for dead peers this often.
+    static constexpr std::chrono::milliseconds PeerCheckInterval{50};
+    // Callers that find every waiter entry taken retry this often.
+    static constexpr std::chrono::milliseconds PollInterval{1};
+
+    struct Slot {
+        std::atomic<std::uint64_t> state;
+        T record;
+
+        explicit Slot(std::uint64_t turn) : state(make_state(static_cast<std::uint32_t>(turn), NoOwner)), record() {}
+    };
+
+    static constexpr size_t slots_offset() {
+        constexpr size_t align = alignof(Slot) > 64 ? alignof(Slot) : 64;
+        return (sizeof(detail::SharedMemoryQueueHeader) + align - 1) / align * align;
+    }
+
+    static std::uint64_t make_state(std::uint32_t turn, std::uint32_t owner) {
+        return (static_cast<std::uint64_t>(turn) << 32) | owner;
+    }
+
+    static std::uint32_t turn_of(std::uint64_t state) {
+        return static_cast<std::uint32_t>(state >> 32);
+    }
+
+    static std::uint32_t owner_of(std::uint64_t state) {
+        return static_cast<std::uint32_t>(state);
+    }
+
+    static void* map(int fd, size_t bytes) {
+        return ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    SharedMemoryQueue(void* base, size_t bytes, std::string owned_name)
+        : m_base(base), m_bytes(bytes), m_header(static_cast<detail::SharedMemoryQueueHeader*>(base)),
+          m_slots(reinterpret_cast<Slot*>(static_cast<std::byte*>(base) + slots_offset())),
+          m_mask(m_header->capacity - 1), m_ownedName(std::move(owned_name)) {}
+
+    // Moves a position counter past pos unless someone already has.
+    static void advance(std::atomic<std::uint64_t>& counter, std::uint64_t pos) {
+        counter.compare_exchange_strong(pos, pos + 1, std::memory_order_relaxed, std::memory_order_relaxed);
+    }
+
+    // The state of the slot for pos once it is free for the next lap.
+    std::uint64_t free_state(std::uint64_t pos) const {
+        return make_state(static_cast<std::uint32_t>(pos + m_mask + 1), NoOwner);
+    }
+
+    void release(Slot& slot, std::uint64_t pos) {
+        slot.state.store(free_state(pos), std::memory_order_release);
+        m_header->space.notify_one();
+    }
+
+    // Frees a slot held by a process that no longer exists. Returns false if
+    // the slot is not held, or its holder is alive.
+    bool recover(Slot& slot, std::uint64_t state) {
+        std::uint32_t owner = owner_of(state);
+        if (owner == NoOwner || owner == Abandoned || detail::is_process_alive(static_cast<pid_t>(owner & ~ReaderBit))) {
+            return false;
+        }
+        std::uint32_t turn = turn_of(state);
+        // A reader held the record for turn - 1; a writer was filling turn.
+        std::uint64_t next = (owner & ReaderBit) ? free_state(turn - 1) : make_state(turn + 1, Abandoned);
+        if (slot.state.compare_exchange_strong(state, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+            m_header->abandoned.fetch_add(1, std::memory_order_relaxed);
+            if (owner & ReaderBit) {
+                m_header->space.notify_all();
+            } else {
+                m_header->items.notify_all();
+            }
+        }
+        return true;
+    }
+
+    // Runs attempt until it returns a value, parking on event in between.
+    // Parks at most PeerCheckInterval at a time so a slot held by a peer
+    // that died is noticed even though nobody will notify.
+    template<typename Attempt>
+    bool wait_until_done(detail::SharedEventCount& event, std::chrono::nanoseconds timeout, Attempt&& attempt) {
+        auto start = std::chrono::steady_clock::now();
+        while (true) {
+            if (std::optional<bool> done = attempt()) {
+                return *done;
+            }
+            auto key = event.prepare_wait(detail::current_pid());
+            if (std::optional<bool> done = attempt()) {
+                if (key) {
+                    event.cancel_wait(*key);
+                }
+                return *done;
+            }
+            auto waited = std::chrono::steady_clock::now() - start;
+            if (waited >= timeout) {
+                if (key) {
+                    event.cancel_wait(*key);
+                }
+                return false;
+            }
+            auto left = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout - waited);
+            if (!key) {
+                std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(left, PollInterval));
+                continue;
+            }
+            event.wait_for(*key, std::min<std::chrono::nanoseconds>(left, PeerCheckInterval));
+        }
+    }
+
+    void* m_base;
+    size_t m_bytes;
+    detail::SharedMemoryQueueHeader* m_header;
+    Slot* m_slots;
+    std::uint64_t m_mask;
+    std::string m_ownedName;
+};
@@ -0,0 +1,193 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "ThreadPool.h"
+
+namespace detail {
+
+// Vyukov's intrusive multi-producer single-consumer queue. push() is
+// wait-free; pop() may briefly see a push that has claimed the head but
+// not yet linked its node, and reports that as empty.
+template<typename T>
+class MpscQueue {
+public:
+    MpscQueue() : m_head(&m_stub), m_tail(&m_stub) {
+        m_stub.next.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~MpscQueue() {
+        T value;
+        while (pop(value)) {
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        push_node(new Node(std::move(value)));
+    }
+
+    // Single consumer only.
+    bool pop(T& value) {
+        Node* tail = m_tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (tail == &m_stub) {
+            if (next == nullptr) {
+                return false;
+            }
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            m_tail = next;
+            value = std::move(tail->value);
+            delete tail;
+            return true;
+        }
+        if (tail != m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        // tail is the last node; put the stub behind it so it can be taken.
+        push_node(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) {
+            return false;
+        }
+        m_tail = next;
+        value = std::move(tail->value);
+        delete tail;
+        return true;
+    }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T v) : value(std::move(v)) {}
+
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    void push_node(Node* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* previous = m_head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    Node m_stub;
+    std::atomic<Node*> m_head;
+    Node* m_tail;
+};
+
+} // namespace detail
+
+// Runs posted tasks one at a time, in posting order, on whichever pool
+// worker is free. A strand has no thread of its own and holds no lock while
+// its tasks run, so any number of strands can share one ThreadPool.
+class Strand {
+public:
+    using Task = std::function<void()>;
+
+    explicit Strand(ThreadPool& threadPool, size_t batch_size = 64)
+        : m_state(std::make_shared<State>(threadPool, batch_size)) {}
+
+    Strand(const Strand&) = delete;
+    Strand& operator=(const Strand&) = delete;
+
+    // Tasks still queued when the strand is destroyed are run anyway; the
+    // scheduled drain keeps the strand's state alive.
+    void post(Task task) {
+        if (!task) {
+            return;
+        }
+        m_state->tasks.push(std::move(task));
+        if (m_state->pending.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            State::schedule(m_state);
+        }
+    }
+
+    // Runs task inline if the calling thread is already running this
+    // strand's tasks, otherwise posts it.
+    void dispatch(Task task) {
+        if (running_in_this_thread()) {
+            task();
+            return;
+        }
+        post(std::move(task));
+    }
+
+    bool running_in_this_thread() const {
+        return current() == m_state.get();
+    }
+
+private:
+    struct State {
+        State(ThreadPool& threadPool, size_t batch_size)
+            : threadPool(threadPool), batchSize(batch_size == 0 ? 1 : batch_size), pending(0) {}
+
+        // Exactly one drain is scheduled while pending is non-zero. If the
+        // pool refuses or drops it, the strand is drained on that thread
+        // instead of stalling.
+        static void schedule(const std::shared_ptr<State>& state) {
+            if (!try_schedule(state)) {
+                drain(state);
+            }
+        }
+
+        static bool try_schedule(const std::shared_ptr<State>& state) {
+            ThreadPool::Task task = state->threadPool.guard_drop(
+                [state]() { drain(state); },
+                [state]() { drain(state); });
+            return state->threadPool.try_enqueue(std::move(task));
+        }
+
+        // Runs batches of up to batchSize tasks, handing the worker back to
+        // other work between batches.
+        static void drain(const std::shared_ptr<State>& state) {
+            State* previous = current();
+            current() = state.get();
+            while (run_batch(*state) && !try_schedule(state)) {
+            }
+            current() = previous;
+        }
+
+        // Returns true if tasks remain.
+        static bool run_batch(State& state) {
+            for (size_t run = 0; run < state.batchSize; ++run) {
+                Task task;
+                while (!state.tasks.pop(task)) {
+                    // A producer has counted its task but not linked it yet.
+                    std::this_thread::yield();
+                }
+                try {
+                    task();
+                } catch (const std::exception& e) {
+                    std::cerr << "Exception in strand task: " << e.what() << std::endl;
+                }
+                task = nullptr;
+                if (state.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        ThreadPool& threadPool;
+        const size_t batchSize;
+        detail::MpscQueue<Task> tasks;
+        std::atomic<size_t> pending;
+    };
+
+    static State*& current() {
+        thread_local State* state = nullptr;
+        return state;
+    }
+
+    std::shared_ptr<State> m_state;
+};
@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "CancellationToken.h"
+
+class TaskGroupException : public std::runtime_error {
+public:
+    explicit TaskGroupException(std::vector<std::exception_ptr> exceptions)
+        : std::runtime_error(describe(exceptions)), m_exceptions(std::move(exceptions)) {}
+
+    const std::vector<std::exception_ptr>& exceptions() const {
+        return m_exceptions;
+    }
+
+private:
+    static std::string describe(const std::vector<std::exception_ptr>& exceptions) {
+        std::string message = std::to_string(exceptions.size()) + " task(s) failed";
+        try {
+            std::rethrow_exception(exceptions.front());
+        } catch (const std::exception& e) {
+            message += ", first: ";
+            message += e.what();
+        } catch (...) {
+        }
+        return message;
+    }
+
+    std::vector<std::exception_ptr> m_exceptions;
+};
+
+// Owns a set of tasks running on a ThreadPool. The group cannot be destroyed
+// before all of its tasks have finished.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& threadPool, const CancellationToken& parent_token = CancellationToken())
+        : m_threadPool(threadPool), m_state(std::make_shared<State>(parent_token)) {}
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    ~TaskGroup() {
+        if (std::uncaught_exceptions() > 0) {
+            cancel_all();
+        }
+        join();
+    }
+
+    // Accepts callables taking no arguments or the group's CancellationToken.
+    // Tasks that have not started when the group is cancelled are skipped.
+    template<typename F>
+    void spawn(F&& task) {
+        if (is_cancelled()) {
+            return;
+        }
+        m_state->pending.fetch_add(1, std::memory_order_relaxed);
+        try {
+            enqueue(std::forward<F>(task));
+        } catch (...) {
+            m_state->finish_task();
+            throw;
+        }
+    }
+
+    // Waits for every spawned task, running queued pool tasks on the calling
+    // thread while any are available. Throws TaskGroupException if tasks
+    // failed since the last wait().
+    void wait() {
+        join();
+
+        std::vector<std::exception_ptr> exceptions;
+        {
+            std::lock_guard<std::mutex> lock(m_state->exceptionMutex);
+            exceptions.swap(m_state->exceptions);
+        }
+        if (!exceptions.empty()) {
+            throw TaskGroupException(std::move(exceptions));
+        }
+    }
+
+    void cancel_all() {
+        m_state->cancellation.request_cancellation();
+    }
+
+    bool is_cancelled() const {
+        return m_state->cancellation.is_cancellation_requested();
+    }
+
+    CancellationToken get_token() const {
+        return m_state->cancellation.get_token();
+    }
+
+    size_t pending_count() const {
+        return m_state->pending.load(std::memory_order_acquire);
+    }
+
+private:
+    struct State {
+        explicit State(const CancellationToken& parent_token) : cancellation(parent_token), pending(0) {}
+
+        void finish_task() {
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                pending.notify_all();
+            }
+        }
+
+        CancellationSource cancellation;
+        std::atomic<size_t> pending;
+        std::mutex exceptionMutex;
+        std::vector<std::exception_ptr> exceptions;
+    };
+
+    template<typename F>
+    void enqueue(F&& task) {
+        // Tasks hold the shared state, so a finishing task never touches a
+        // group that its waiter has already destroyed.
+        ThreadPool::Task run = [state = m_state, task = std::forward<F>(task)]() mutable {
+            CancellationToken token = state->cancellation.get_token();
+            if (!token.is_cancellation_requested()) {
+                try {
+                    if constexpr (std::is_invocable_v<F&, const CancellationToken&>) {
+                        task(token);
+                    } else {
+                        task();
+                    }
+                } catch (const OperationCancelledException&) {
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(state->exceptionMutex);
+                    state->exceptions.push_back(std::current_exception());
+                }
+            }
+            state->finish_task();
+        };
+        m_threadPool.enqueue(m_threadPool.guard_drop(std::move(run), [state = m_state]() { state->finish_task(); }));
+    }
+
+    void join() {
+        State& state = *m_state;
+        size_t pending = state.pending.load(std::memory_order_acquire);
+        while (pending != 0) {
+            if (!m_threadPool.run_pending_task()) {
+                state.pending.wait(pending, std::memory_order_acquire);
+            }
+            pending = state.pending.load(std::memory_order_acquire);
+        }
+    }
+
+    ThreadPool& m_threadPool;
+    std::shared_ptr<State> m_state;
+};
@@ -1,44 +1,103 @@
 #pragma once
+#include <chrono>
 #include <functional>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
 #include <thread>
 #include <vector>
 #include <atomic>
-#include <condition_variable>
-#include <mutex>
-#include "LockFreeQueue.h"
+#include "AdmissionController.h"
+#include "EventCount.h"
+#include "LockFreeTaskQueue.h"
+#include "SchedulePoint.h"
+
+class RejectedExecutionException : public std::runtime_error {
+public:
+    explicit RejectedExecutionException(const std::string& message) : std::runtime_error(message) {}
+};
+
+// What enqueue() does when a bounded pool already holds capacity tasks.
+enum class OverflowPolicy {
+    Block,      // wait until a worker takes a task
+    Reject,     // throw RejectedExecutionException
+    DropOldest, // discard the longest-queued task to make room
+    CallerRuns  // run the task on the calling thread
+};
+
+// What shutdown() does with tasks that are still queued. In every mode the
+// pool stops accepting tasks from other threads at once; tasks running on
+// its workers may still enqueue follow-up work, which is treated like the
+// rest of the queue. Running tasks are never interrupted.
+enum class ShutdownMode {
+    Drain,         // run everything queued, then stop
+    CancelPending, // discard queued tasks without running them
+    DeadlineDrain  // drain until the timeout, then discard what is left
+};
+
+namespace detail {
+
+// Set while a pool destroys a task it refused. The submitter learns of the
+// refusal from the return value or exception, so drop guards stay quiet.
+inline bool& refusing_task() {
+    static thread_local bool refusing = false;
+    return refusing;
+}
+
+template<typename F, typename OnDrop>
+class DropGuard {
+public:
+    DropGuard(F task, OnDrop on_drop) : m_task(std::move(task)), m_onDrop(std::move(on_drop)), m_ran(false) {}
+
+    ~DropGuard() {
+        if (!m_ran && !refusing_task()) {
+            m_onDrop();
+        }
+    }
+
+    void run() {
+        m_ran = true;
+        m_task();
+    }
+
+private:
+    F m_task;
+    OnDrop m_onDrop;
+    bool m_ran;
+};
+
+} // namespace detail
 
 class ThreadPool {
 public:
     using Task = std::function<void()>;
 
     explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency())
-        : m_threads(threadCount), m_running(true), m_idleThreads(threadCount) {
+        : ThreadPool(threadCount, 0) {}
+
+    // A capacity of 0 leaves the queue unbounded. With an admission
+    // controller, tasks report their queue sojourn time and new tasks are
+    // rejected while it reports overload, whatever the overflow policy.
+    ThreadPool(size_t threadCount, size_t capacity, OverflowPolicy policy = OverflowPolicy::Block,
+               std::shared_ptr<AdmissionController> admission = nullptr)
+        : m_threads(threadCount), m_running(true), m_idleThreads(threadCount),
+          m_capacity(capacity), m_policy(policy), m_queued(0), m_inFlight(0), m_accepting(true),
+          m_discarding(false), m_shutDown(false), m_admission(std::move(admission)) {
         for (auto& thread : m_threads) {
             thread = std::thread([this]() {
-                while (m_running) {
-                    Task task;
-                    {
-                        std::unique_lock<std::mutex> lock(m_mutex);
-                        m_condition.wait(lock, [this] { return !m_running || !m_queue.is_empty(); });
-
-                        if (!m_running && m_queue.is_empty()) {
-                            return;
-                        }
-
-                        auto task_opt = m_queue.dequeue();
-                        if (!task_opt) {
-                            continue;
-                        }
-                        task = std::move(*task_opt);
-                    }
-
-                    m_idleThreads--;
-                    try {
-                        task();
-                    } catch (const std::exception& e) {
-                        std::cerr << "Exception in thread pool task: " << e.what() << std::endl;
+                current_pool() = this;
+                Task task;
+                while (m_queue.pop(task)) {
+                    ASYNC_SCHEDULE_POINT();
+                    release_slot();
+                    if (!m_discarding.load(std::memory_order_acquire)) {
+                        m_idleThreads--;
+                        run_task(task);
+                        m_idleThreads++;
                     }
-                    m_idleThreads++;
+                    task = nullptr;
+                    finish_task();
                 }
             });
         }
@@ -48,39 +107,290 @@ public:
         shutdown();
     }
 
+    // Applies the overflow policy when the pool is full. Throws
+    // RejectedExecutionException if the task is refused. A Block pool must
+    // not be fed from its own workers, since they may be the only ones that
+    // can make room.
     void enqueue(Task task) {
-        if (!task) {
-            return;
+        if (!submit(std::move(task), false)) {
+            throw RejectedExecutionException("ThreadPool: task rejected");
         }
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_queue.enqueue(std::move(task));
+    }
+
+    // Like enqueue(), but returns false instead of throwing or blocking.
+    bool try_enqueue(Task task) {
+        return submit(std::move(task), true);
+    }
+
+    // Wraps task so that on_drop runs instead if the pool accepts it but
+    // discards it without running it: OverflowPolicy::DropOldest, or a
+    // shutdown that cancels pending tasks. Refused tasks do not trigger
+    // on_drop.
+    template<typename F, typename OnDrop>
+    Task guard_drop(F task, OnDrop on_drop) const {
+        auto guard = std::make_shared<detail::DropGuard<F, OnDrop>>(std::move(task), std::move(on_drop));
+        return [guard]() { guard->run(); };
+    }
+
+    // For continuations that must not be lost: if the pool refuses or drops
+    // task, it runs on that thread instead.
+    void post_or_run(Task task) {
+        Task guarded = guard_drop(task, [task]() { task(); });
+        if (!try_enqueue(std::move(guarded))) {
+            task();
+        }
+    }
+
+    // Runs one queued task on the calling thread, so threads that wait for
+    // pool work can help instead of blocking. Returns false if the queue was
+    // empty.
+    bool run_pending_task() {
+        Task task;
+        if (!m_queue.try_pop(task)) {
+            return false;
         }
-        m_condition.notify_one();
+        release_slot();
+        if (!m_discarding.load(std::memory_order_acquire)) {
+            run_task(task);
+        }
+        task = nullptr;
+        finish_task();
+        return true;
     }
 
-    void shutdown() {
-        {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            m_running = false;
+    // Stops the pool and joins its workers; see ShutdownMode. timeout only
+    // applies to DeadlineDrain. Calls after the first return at once. Must
+    // not be called from one of the pool's own tasks.
+    void shutdown(ShutdownMode mode = ShutdownMode::Drain,
+                  std::chrono::steady_clock::duration timeout = std::chrono::steady_clock::duration::zero()) {
+        if (m_shutDown.exchange(true)) {
+            return;
+        }
+        m_accepting.store(false, std::memory_order_seq_cst);
+        if (mode == ShutdownMode::Drain) {
+            wait_idle();
+        } else if (mode == ShutdownMode::CancelPending || !wait_idle_for(timeout)) {
+            m_discarding.store(true, std::memory_order_release);
         }
-        m_condition.notify_all();
+
+        m_running = false;
+        m_queue.stop();
+        m_space.notify_all();
         for (auto& thread : m_threads) {
             if (thread.joinable()) {
                 thread.join();
             }
         }
+
+        // Submitters that raced with shutdown, and tasks discarded after the
+        // workers left, are settled here.
+        while (m_inFlight.load(std::memory_order_acquire) != 0) {
+            if (!run_pending_task()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Blocks until no task is queued or running. Tasks submitted meanwhile
+    // extend the wait, so callers should stop feeding the pool first. Must
+    // not be called from one of the pool's own tasks.
+    void wait_idle() {
+        wait_idle_until(std::nullopt);
+    }
+
+    // Like wait_idle(), but gives up after timeout. Returns false if tasks
+    // were still in flight.
+    bool wait_idle_for(std::chrono::steady_clock::duration timeout) {
+        return wait_idle_until(std::chrono::steady_clock::now() + timeout);
+    }
+
+    // Tasks queued or running, including ones a worker has just taken.
+    size_t get_in_flight_count() const {
+        return m_inFlight.load(std::memory_order_acquire);
+    }
+
+    bool is_accepting() const {
+        return m_accepting.load(std::memory_order_acquire);
     }
 
     size_t get_idle_thread_count() const {
         return m_idleThreads.load();
     }
 
+    // True if no task is queued or running. A task enqueued concurrently may
+    // not be reflected yet.
+    bool is_idle() const {
+        return m_running && m_inFlight.load(std::memory_order_acquire) == 0;
+    }
+
+    // Number of queued tasks; only tracked for bounded pools.
+    size_t get_queued_count() const {
+        return m_queued.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const {
+        return m_capacity;
+    }
+
+    OverflowPolicy overflow_policy() const {
+        return m_policy;
+    }
+
 private:
-    LockFreeQueue<Task> m_queue;
+    bool submit(Task task, bool non_blocking) {
+        if (!task) {
+            return true;
+        }
+        // Counted before the check, so shutdown() either sees this task or
+        // the submitter sees that the pool stopped accepting.
+        m_inFlight.fetch_add(1, std::memory_order_seq_cst);
+        bool accepting = m_accepting.load(std::memory_order_seq_cst) || current_pool() == this;
+        if (!accepting || !enqueue_counted(task, non_blocking)) {
+            detail::refusing_task() = true;
+            task = nullptr;
+            detail::refusing_task() = false;
+            finish_task();
+            return false;
+        }
+        return true;
+    }
+
+    // Queues a task already counted in m_inFlight, moving it out of task.
+    // Returns false, leaving task and the count to the caller, if it was
+    // refused; CallerRuns tasks are settled here.
+    bool enqueue_counted(Task& task, bool non_blocking) {
+        if (m_admission) {
+            if (!m_admission->admit()) {
+                return false;
+            }
+            task = [this, task = std::move(task), enqueued = AdmissionController::Clock::now()]() {
+                m_admission->record_sojourn(AdmissionController::Clock::now() - enqueued);
+                task();
+            };
+        }
+        if (m_capacity == 0 || reserve_slot()) {
+            ASYNC_SCHEDULE_POINT();
+            m_queue.push(std::move(task));
+            return true;
+        }
+
+        switch (m_policy) {
+        case OverflowPolicy::Reject:
+            return false;
+        case OverflowPolicy::CallerRuns:
+            finish_task();
+            task();
+            return true;
+        case OverflowPolicy::DropOldest:
+            while (true) {
+                Task oldest;
+                ASYNC_SCHEDULE_POINT();
+                if (m_queue.try_pop(oldest)) {
+                    // The slot passes straight to the new task; the dropped
+                    // one is destroyed without running.
+                    m_queue.push(std::move(task));
+                    oldest = nullptr;
+                    finish_task();
+                    return true;
+                }
+                if (reserve_slot()) {
+                    m_queue.push(std::move(task));
+                    return true;
+                }
+            }
+        case OverflowPolicy::Block:
+            if (non_blocking) {
+                return false;
+            }
+            while (!reserve_slot()) {
+                EventCount::Key key = m_space.prepare_wait();
+                if (reserve_slot()) {
+                    m_space.cancel_wait();
+                    break;
+                }
+                if (!m_running) {
+                    m_space.cancel_wait();
+                    return false;
+                }
+                m_space.wait(key);
+            }
+            m_queue.push(std::move(task));
+            return true;
+        }
+        return false;
+    }
+
+    bool reserve_slot() {
+        size_t queued = m_queued.load(std::memory_order_relaxed);
+        while (queued < m_capacity) {
+            if (m_queued.compare_exchange_weak(queued, queued + 1, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void run_task(Task& task) {
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in thread pool task: " << e.what() << std::endl;
+        }
+    }
+
+    void finish_task() {
+        if (m_inFlight.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_quiescent.notify_all();
+        }
+    }
+
+    bool wait_idle_until(std::optional<std::chrono::steady_clock::time_point> deadline) {
+        while (m_inFlight.load(std::memory_order_acquire) != 0) {
+            EventCount::Key key = m_quiescent.prepare_wait();
+            if (m_inFlight.load(std::memory_order_seq_cst) == 0) {
+                m_quiescent.cancel_wait();
+                break;
+            }
+            if (!deadline) {
+                m_quiescent.wait(key);
+                continue;
+            }
+            auto left = *deadline - std::chrono::steady_clock::now();
+            if (left <= std::chrono::steady_clock::duration::zero()) {
+                m_quiescent.cancel_wait();
+                return false;
+            }
+            m_quiescent.wait_for(key, left);
+        }
+        return true;
+    }
+
+    // The pool whose worker is the calling thread, if any.
+    static ThreadPool*& current_pool() {
+        static thread_local ThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    void release_slot() {
+        if (m_capacity == 0) {
+            return;
+        }
+        m_queued.fetch_sub(1, std::memory_order_seq_cst);
+        m_space.notify_one();
+    }
+
+    LockFreeTaskQueue m_queue;
     std::vector<std::thread> m_threads;
     std::atomic<bool> m_running;
     std::atomic<size_t> m_idleThreads;
-    std::mutex m_mutex;
-    std::condition_variable m_condition;
-};
\ No newline at end of file
+    const size_t m_capacity;
+    const OverflowPolicy m_policy;
+    std::atomic<size_t> m_queued;
+    std::atomic<size_t> m_inFlight;
+    std::atomic<bool> m_accepting;
+    std::atomic<bool> m_discarding;
+    std::atomic<bool> m_shutDown;
+    EventCount m_space;
+    EventCount m_quiescent;
+    std::shared_ptr<AdmissionController> m_admission;
+};
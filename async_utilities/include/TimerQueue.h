@@ -0,0 +1,100 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Runs callbacks at a point in time on a single timer thread. Callbacks
+// should be short; anything substantial belongs on a ThreadPool.
+class TimerQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+    TimerQueue() : m_running(true), m_nextSequence(0) {
+        m_thread = std::thread([this]() { loop(); });
+    }
+
+    ~TimerQueue() {
+        stop();
+    }
+
+    TimerQueue(const TimerQueue&) = delete;
+    TimerQueue& operator=(const TimerQueue&) = delete;
+
+    void schedule_at(Clock::time_point when, Callback callback) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_timers.push(Timer{when, m_nextSequence++, std::move(callback)});
+        }
+        m_condition.notify_one();
+    }
+
+    void schedule_after(Clock::duration delay, Callback callback) {
+        schedule_at(Clock::now() + delay, std::move(callback));
+    }
+
+    // Pending timers are discarded without running.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running) {
+                return;
+            }
+            m_running = false;
+        }
+        m_condition.notify_all();
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+private:
+    struct Timer {
+        Clock::time_point when;
+        std::uint64_t sequence;
+        Callback callback;
+
+        // Earliest deadline first, then submission order.
+        bool operator>(const Timer& other) const {
+            return when != other.when ? when > other.when : sequence > other.sequence;
+        }
+    };
+
+    void loop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_running) {
+            if (m_timers.empty()) {
+                m_condition.wait(lock);
+                continue;
+            }
+            Clock::time_point when = m_timers.top().when;
+            if (Clock::now() < when) {
+                m_condition.wait_until(lock, when);
+                continue;
+            }
+            Callback callback = std::move(const_cast<Timer&>(m_timers.top()).callback);
+            m_timers.pop();
+            lock.unlock();
+            try {
+                callback();
+            } catch (const std::exception& e) {
+                std::cerr << "Exception in timer callback: " << e.what() << std::endl;
+            }
+            callback = nullptr;
+            lock.lock();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_timers;
+    bool m_running;
+    std::uint64_t m_nextSequence;
+    std::thread m_thread;
+};
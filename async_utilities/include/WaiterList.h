@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "CancellationToken.h"
+
+namespace detail {
+
+struct Waiter {
+    std::function<void()> resume;
+    CancellationRegistration registration;
+    bool exclusive = false;
+};
+
+// FIFO of continuations waiting for an asynchronous primitive. The list is
+// guarded by its owner's mutex. Waiters are handed back to the owner, which
+// must resume and destroy them after releasing that mutex, because
+// destroying a registration may wait for its callback, which takes the
+// mutex.
+class WaiterList {
+public:
+    using Id = std::uint64_t;
+
+    WaiterList() : m_nextId(1) {}
+
+    // Called with the owner's mutex held.
+    Id push(std::function<void()> resume, bool exclusive = false) {
+        Id id = m_nextId++;
+        m_waiters.push_back({id, Waiter{std::move(resume), CancellationRegistration(), exclusive}});
+        m_index.emplace(id, std::prev(m_waiters.end()));
+        return id;
+    }
+
+    // Called with the owner's mutex held.
+    std::optional<Waiter> pop() {
+        if (m_waiters.empty()) {
+            return std::nullopt;
+        }
+        auto& [id, waiter] = m_waiters.front();
+        std::optional<Waiter> result(std::move(waiter));
+        m_index.erase(id);
+        m_waiters.pop_front();
+        return result;
+    }
+
+    // Called with the owner's mutex held.
+    std::optional<Waiter> remove(Id id) {
+        auto it = m_index.find(id);
+        if (it == m_index.end()) {
+            return std::nullopt;
+        }
+        std::optional<Waiter> result(std::move(it->second->second));
+        m_waiters.erase(it->second);
+        m_index.erase(it);
+        return result;
+    }
+
+    // Called with the owner's mutex held.
+    const Waiter* front() const {
+        return m_waiters.empty() ? nullptr : &m_waiters.front().second;
+    }
+
+    bool empty() const {
+        return m_waiters.empty();
+    }
+
+    size_t size() const {
+        return m_waiters.size();
+    }
+
+    // Called without the owner's mutex. Cancelling token removes the waiter
+    // without resuming it; on_cancel then runs after the mutex has been
+    // released, so the owner can re-examine waiters the removed one was
+    // holding back.
+    void watch(std::mutex& mutex, Id id, const CancellationToken& token,
+               std::function<void()> on_cancel = nullptr) {
+        if (!token.can_be_cancelled()) {
+            return;
+        }
+        CancellationRegistration registration(token, [this, &mutex, id, on_cancel]() {
+            std::optional<Waiter> removed;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                removed = remove(id);
+            }
+            if (removed && on_cancel) {
+                on_cancel();
+            }
+        });
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = m_index.find(id);
+        if (it != m_index.end()) {
+            std::swap(it->second->second.registration, registration);
+        }
+    }
+
+private:
+    std::list<std::pair<Id, Waiter>> m_waiters;
+    std::unordered_map<Id, std::list<std::pair<Id, Waiter>>::iterator> m_index;
+    Id m_nextId;
+};
+
+} // namespace detail
@@ -0,0 +1,357 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "AsyncExecutor.h"
+#include "LockFreeQueue.h"
+#include "LockFreeStack.h"
+#include "LockFreeTaskQueue.h"
+#include "ObjectPool.h"
+#include "SharedMemoryQueue.h"
+#include "TaskQueue.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void report(const std::string& name, Clock::duration total, size_t iterations) {
+    double micros = std::chrono::duration<double, std::micro>(total).count() / static_cast<double>(iterations);
+    std::cout << "  " << std::left << std::setw(56) << name
+              << std::right << std::fixed << std::setprecision(2) << std::setw(12) << micros << " us/op" << std::endl;
+}
+
+// Measures submit -> callback on the owner thread for results of
+// result_bytes, with the callback taking the result by const reference
+// (shared result) or by value (one deep copy, as before results were shared).
+void bench_large_results(size_t result_bytes, size_t iterations) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    AsyncExecutor<std::vector<std::byte>> executor(pool, dispatcher);
+    using Buffer = std::vector<std::byte>;
+
+    auto run = [&](auto callback_factory) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            bool done = false;
+            auto op = executor.start([result_bytes]() { return Buffer(result_bytes, std::byte{1}); },
+                                     callback_factory(done));
+            while (!done) {
+                dispatcher.execute_pending();
+            }
+            size_t size = op->getFuture().get().size();
+            if (size != result_bytes) {
+                std::cerr << "unexpected result size" << std::endl;
+            }
+        }
+        return Clock::now() - start;
+    };
+
+    // Warm-up so both variants start with the allocator in the same state.
+    run([](bool& done) { return [&done](const Buffer&) { done = true; }; });
+
+    std::cout << "Large results (" << result_bytes / 1024 << " KiB):" << std::endl;
+    report("shared result, callback(const Buffer&)", run([](bool& done) {
+        return [&done](const Buffer& buffer) { done = !buffer.empty(); };
+    }), iterations);
+    report("copied result, callback(Buffer)", run([](bool& done) {
+        return [&done](Buffer buffer) { done = !buffer.empty(); };
+    }), iterations);
+}
+
+// Latency of start -> callback for a no-op operation under policy. Bound
+// callbacks are drained from the dispatcher by the submitting thread;
+// unbound ones are only awaited.
+void bench_noop_round_trip(const std::string& name, ExecutionPolicy policy, size_t iterations) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    AsyncExecutor<int> executor(pool, dispatcher, policy);
+    std::atomic<bool> done{false};
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        done.store(false, std::memory_order_relaxed);
+        executor.start([]() { return 0; }, [&done](const int&) { done.store(true, std::memory_order_release); });
+        while (!done.load(std::memory_order_acquire)) {
+            if (policy.bind_callbacks || !policy.inline_callbacks) {
+                dispatcher.execute_pending();
+            }
+            std::this_thread::yield();
+        }
+    }
+    report(name, Clock::now() - start, iterations);
+}
+
+void bench_noop_round_trips(size_t iterations) {
+    std::cout << "No-op start -> callback:" << std::endl;
+    bench_noop_round_trip("callback via dispatcher (default)", ExecutionPolicy(), iterations);
+    bench_noop_round_trip("inline callback on worker", ExecutionPolicy{false, true, false}, iterations);
+    bench_noop_round_trip("run_inline_if_idle + inline callback", ExecutionPolicy{false, true, true}, iterations);
+}
+
+// threads producers and threads consumers move total_tasks tasks through
+// the queue; reports the time per task.
+template<typename Queue>
+Clock::duration run_task_queue(size_t threads, size_t total_tasks) {
+    Queue queue;
+    std::atomic<size_t> executed{0};
+    std::vector<std::thread> consumers;
+    std::vector<std::thread> producers;
+    size_t per_producer = total_tasks / threads;
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < threads; ++i) {
+        consumers.emplace_back([&queue]() {
+            typename Queue::Task task;
+            while (queue.pop(task)) {
+                task();
+            }
+        });
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        producers.emplace_back([&queue, &executed, per_producer]() {
+            for (size_t j = 0; j < per_producer; ++j) {
+                queue.push([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); });
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    while (executed.load(std::memory_order_relaxed) < per_producer * threads) {
+        std::this_thread::yield();
+    }
+    auto elapsed = Clock::now() - start;
+
+    queue.stop();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+    return elapsed;
+}
+
+void bench_task_queues(size_t total_tasks) {
+    std::cout << "Task queues (" << total_tasks << " tasks, N producers + N consumers):" << std::endl;
+    for (size_t threads : {1, 2, 4, 8, 16, 32, 64}) {
+        size_t tasks = total_tasks / threads * threads;
+        report("TaskQueue (mutex), N=" + std::to_string(threads),
+               run_task_queue<TaskQueue>(threads, tasks), tasks);
+        report("LockFreeTaskQueue, N=" + std::to_string(threads),
+               run_task_queue<LockFreeTaskQueue>(threads, tasks), tasks);
+    }
+}
+
+// Each thread repeatedly takes a scratch buffer of buffer_bytes, touches
+// it and gives it back; reports the time per buffer.
+template<typename Acquire>
+Clock::duration run_scratch_buffers(size_t threads, size_t per_thread, Acquire acquire) {
+    std::vector<std::thread> workers;
+    std::atomic<size_t> checksum{0};
+    auto start = Clock::now();
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&acquire, &checksum, per_thread]() {
+            size_t sum = 0;
+            for (size_t j = 0; j < per_thread; ++j) {
+                auto buffer = acquire();
+                (*buffer)[j % buffer->size()] = std::byte{1};
+                sum += static_cast<size_t>((*buffer)[0]);
+            }
+            checksum.fetch_add(sum, std::memory_order_relaxed);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return Clock::now() - start;
+}
+
+void bench_scratch_buffers(size_t buffer_bytes, size_t per_thread) {
+    using Buffer = std::vector<std::byte>;
+    std::cout << "Scratch buffers (" << buffer_bytes / 1024 << " KiB, per-thread time per buffer):" << std::endl;
+    for (size_t threads : {1, 2, 4, 8, 16}) {
+        report("new/delete, N=" + std::to_string(threads),
+               run_scratch_buffers(threads, per_thread, [buffer_bytes]() {
+                   return std::make_unique<Buffer>(buffer_bytes);
+               }) * threads, per_thread * threads);
+        BufferPool pool;
+        report("BufferPool, N=" + std::to_string(threads),
+               run_scratch_buffers(threads, per_thread, [&pool, buffer_bytes]() {
+                   return pool.acquire(buffer_bytes);
+               }) * threads, per_thread * threads);
+    }
+}
+
+// threads producers and threads consumers pass per_thread ints each through
+// a LockFreeQueue with the given policy; reports the time per message.
+template<typename Policy>
+Clock::duration run_message_queue(size_t threads, size_t per_thread) {
+    LockFreeQueue<size_t, Policy> queue;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> checksum{0};
+    auto start = Clock::now();
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&queue, per_thread]() {
+            for (size_t j = 0; j < per_thread; ++j) {
+                queue.enqueue(j);
+            }
+        });
+        workers.emplace_back([&queue, &checksum, per_thread]() {
+            size_t sum = 0;
+            for (size_t j = 0; j < per_thread; ++j) {
+                std::optional<size_t> value;
+                while (!(value = queue.dequeue())) {
+                    std::this_thread::yield();
+                }
+                sum += *value;
+            }
+            checksum.fetch_add(sum, std::memory_order_relaxed);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return Clock::now() - start;
+}
+
+// Each thread pushes batch ints onto a shared LockFreeStack and pops them
+// back, rounds times; reports the time per push/pop pair.
+template<typename Policy>
+Clock::duration run_message_stack(size_t threads, size_t rounds, size_t batch) {
+    LockFreeStack<size_t, Policy> stack;
+    std::vector<std::thread> workers;
+    auto start = Clock::now();
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&stack, rounds, batch]() {
+            for (size_t r = 0; r < rounds; ++r) {
+                for (size_t j = 0; j < batch; ++j) {
+                    stack.push(j);
+                }
+                for (size_t j = 0; j < batch; ++j) {
+                    while (!stack.pop()) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return Clock::now() - start;
+}
+
+template<typename Policy>
+void report_message_policy(const std::string& name, size_t threads, size_t per_thread) {
+    size_t total = per_thread * threads;
+    report("LockFreeQueue " + name + ", N=" + std::to_string(threads),
+           run_message_queue<Policy>(threads, per_thread), total);
+    report("LockFreeStack " + name + ", N=" + std::to_string(threads),
+           run_message_stack<Policy>(threads, per_thread / 64, 64), total);
+}
+
+void bench_message_policies(size_t per_thread) {
+    using Inline = ContainerPolicy<NodeStorage::Inline>;
+    using Reserved = ContainerPolicy<NodeStorage::Inline, true, 4096>;
+    using SeqCst = ContainerPolicy<NodeStorage::Inline, true, 0, MemoryOrdering::SequentiallyConsistent>;
+    std::cout << "Container policies (size_t messages, time per message):" << std::endl;
+    for (size_t threads : {1, 2, 4}) {
+        report_message_policy<DefaultContainerPolicy>("indirect", threads, per_thread);
+        report_message_policy<Inline>("inline", threads, per_thread);
+        report_message_policy<MessageContainerPolicy>("inline+padded", threads, per_thread);
+        report_message_policy<Reserved>("inline+padded+reserve", threads, per_thread);
+        report_message_policy<SeqCst>("inline+padded, seq_cst", threads, per_thread);
+    }
+}
+
+struct JobRecord {
+    std::uint64_t id;
+    std::uint32_t kind;
+    std::uint32_t size;
+    char payload[48];
+};
+
+// A child process consumes count records that the parent produces; reports
+// the time per record from the first push until the child has exited.
+Clock::duration run_shared_memory_handoff(size_t count) {
+    std::string name = "/async_bench_" + std::to_string(::getpid());
+    SharedMemoryQueue<JobRecord>::unlink(name);
+    auto queue = SharedMemoryQueue<JobRecord>::create(name, 1024);
+    auto start = Clock::now();
+    pid_t child = ::fork();
+    if (child == 0) {
+        auto jobs = SharedMemoryQueue<JobRecord>::open(name);
+        JobRecord record{};
+        std::uint64_t sum = 0;
+        while (jobs.pop(record)) {
+            sum += record.id;
+        }
+        ::_exit(sum == count * (count - 1) / 2 ? 0 : 1);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        queue.push(JobRecord{i, 1, sizeof(JobRecord), "job"});
+    }
+    queue.stop();
+    ::waitpid(child, nullptr, 0);
+    return Clock::now() - start;
+}
+
+// The same handoff as one write()/read() per record over a socketpair.
+Clock::duration run_socket_handoff(size_t count) {
+    int fds[2];
+    ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    auto start = Clock::now();
+    pid_t child = ::fork();
+    if (child == 0) {
+        ::close(fds[0]);
+        JobRecord record{};
+        size_t got = 0;
+        auto* bytes = reinterpret_cast<char*>(&record);
+        while (true) {
+            ssize_t n = ::read(fds[1], bytes + got, sizeof(record) - got);
+            if (n <= 0) {
+                break;
+            }
+            got = (got + static_cast<size_t>(n)) % sizeof(record);
+        }
+        ::_exit(0);
+    }
+    ::close(fds[1]);
+    for (size_t i = 0; i < count; ++i) {
+        JobRecord record{i, 1, sizeof(JobRecord), "job"};
+        (void)::write(fds[0], &record, sizeof(record));
+    }
+    ::close(fds[0]);
+    ::waitpid(child, nullptr, 0);
+    return Clock::now() - start;
+}
+
+void bench_cross_process(size_t count) {
+    std::cout << "Cross-process handoff (" << sizeof(JobRecord) << "-byte records, time per record):" << std::endl;
+    report("socketpair write/read", run_socket_handoff(count), count);
+    report("SharedMemoryQueue push/pop", run_shared_memory_handoff(count), count);
+}
+
+}
+
+int main() {
+    std::cout << "AsyncSystem benchmarks" << std::endl;
+    bench_large_results(64 * 1024, 2000);
+    bench_large_results(8 * 1024 * 1024, 50);
+    bench_noop_round_trips(20000);
+    bench_task_queues(200000);
+    bench_scratch_buffers(256 * 1024, 20000);
+    bench_message_policies(100000);
+    bench_cross_process(200000);
+    return 0;
+}
@@ -0,0 +1,653 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AsyncExecutor.h"
+#include "Executor.h"
+#include "CancellationToken.h"
+#include "TaskGroup.h"
+
+using namespace std::chrono_literals;
+
+TEST(CancellationTokenTest, CallbacksRunOnceOnCancel) {
+    CancellationSource source;
+    std::atomic<int> calls{0};
+    CancellationRegistration first(source.get_token(), [&calls]() { calls++; });
+    CancellationRegistration second(source.get_token(), [&calls]() { calls++; });
+
+    EXPECT_FALSE(source.get_token().is_cancellation_requested());
+    EXPECT_TRUE(source.request_cancellation());
+    EXPECT_FALSE(source.request_cancellation());
+
+    EXPECT_TRUE(source.get_token().is_cancellation_requested());
+    EXPECT_THROW(source.get_token().throw_if_cancellation_requested(), OperationCancelledException);
+    EXPECT_EQ(calls.load(), 2);
+}
+
+TEST(CancellationTokenTest, RegistrationAfterCancelRunsImmediately) {
+    CancellationSource source;
+    source.request_cancellation();
+
+    bool called = false;
+    CancellationRegistration registration(source.get_token(), [&called]() { called = true; });
+    EXPECT_TRUE(called);
+}
+
+TEST(CancellationTokenTest, DestroyedRegistrationIsNotInvoked) {
+    CancellationSource source;
+    bool called = false;
+    {
+        CancellationRegistration registration(source.get_token(), [&called]() { called = true; });
+    }
+    source.request_cancellation();
+    EXPECT_FALSE(called);
+}
+
+TEST(CancellationTokenTest, LinkedSourceFollowsParent) {
+    CancellationSource parent;
+    CancellationSource child(parent.get_token());
+    CancellationSource grandchild(child.get_token());
+
+    child.request_cancellation();
+    EXPECT_FALSE(parent.is_cancellation_requested());
+    EXPECT_TRUE(grandchild.is_cancellation_requested());
+
+    CancellationSource sibling(parent.get_token());
+    parent.request_cancellation();
+    EXPECT_TRUE(sibling.is_cancellation_requested());
+
+    CancellationSource late_child(parent.get_token());
+    EXPECT_TRUE(late_child.is_cancellation_requested());
+}
+
+TEST(AsyncExecutorCancellationTest, RunningOperationObservesToken) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    AsyncExecutor<int> executor(pool, dispatcher);
+    std::atomic<bool> started{false};
+
+    auto op = executor.start([&started](const CancellationToken& token) {
+        started = true;
+        while (!token.is_cancellation_requested()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        token.throw_if_cancellation_requested();
+        return 0;
+    });
+
+    while (!started) {
+        std::this_thread::yield();
+    }
+    op->cancel();
+
+    auto future = op->getFuture();
+    EXPECT_THROW(future.get(), OperationCancelledException);
+}
+
+TEST(AsyncExecutorCancellationTest, QueuedOperationsAreReclaimedWithoutRunning) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    AsyncExecutor<int> executor(pool, dispatcher);
+    std::atomic<bool> release{false};
+    std::atomic<int> executed{0};
+
+    auto blocker = executor.start([&release]() {
+        while (!release) {
+            std::this_thread::sleep_for(1ms);
+        }
+        return 0;
+    });
+
+    CancellationSource batch;
+    auto payload = std::make_shared<std::vector<char>>(1024);
+    std::weak_ptr<std::vector<char>> weak_payload = payload;
+    std::vector<std::shared_ptr<CancellableOperation<int>>> operations;
+    for (int i = 0; i < 10000; ++i) {
+        operations.push_back(executor.start([payload, &executed]() {
+            executed++;
+            return static_cast<int>(payload->size());
+        }, std::nullopt, std::nullopt, batch.get_token()));
+    }
+    payload.reset();
+
+    batch.request_cancellation();
+
+    EXPECT_TRUE(weak_payload.expired());
+    for (auto& op : operations) {
+        auto future = op->getFuture();
+        ASSERT_EQ(future.wait_for(0s), std::future_status::ready);
+        EXPECT_THROW(future.get(), OperationCancelledException);
+    }
+
+    release = true;
+    EXPECT_EQ(blocker->getFuture().get(), 0);
+    pool.shutdown();
+    EXPECT_EQ(executed.load(), 0);
+}
+
+TEST(TaskGroupTest, WaitJoinsAllTasks) {
+    ThreadPool pool(4);
+    TaskGroup group(pool);
+    std::atomic<int> sum{0};
+
+    for (int i = 1; i <= 1000; ++i) {
+        group.spawn([&sum, i]() { sum += i; });
+    }
+    group.wait();
+
+    EXPECT_EQ(sum.load(), 500500);
+    EXPECT_EQ(group.pending_count(), 0u);
+}
+
+TEST(TaskGroupTest, WaitingThreadHelpsExecuteQueuedTasks) {
+    ThreadPool pool(1);
+    std::atomic<bool> release{false};
+    pool.enqueue([&release]() {
+        while (!release) {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+    while (pool.get_idle_thread_count() != 0) {
+        std::this_thread::yield();
+    }
+
+    TaskGroup group(pool);
+    const auto waiter = std::this_thread::get_id();
+    std::atomic<int> ran_on_waiter{0};
+    for (int i = 0; i < 100; ++i) {
+        group.spawn([&ran_on_waiter, waiter]() {
+            if (std::this_thread::get_id() == waiter) {
+                ran_on_waiter++;
+            }
+        });
+    }
+    group.wait();
+    release = true;
+
+    EXPECT_EQ(ran_on_waiter.load(), 100);
+}
+
+TEST(TaskGroupTest, ExceptionsAreAggregated) {
+    ThreadPool pool(2);
+    TaskGroup group(pool);
+
+    for (int i = 0; i < 10; ++i) {
+        group.spawn([i]() {
+            if (i % 2 == 0) {
+                throw std::runtime_error("task failed");
+            }
+        });
+    }
+
+    try {
+        group.wait();
+        FAIL() << "expected TaskGroupException";
+    } catch (const TaskGroupException& e) {
+        EXPECT_EQ(e.exceptions().size(), 5u);
+        EXPECT_THROW(std::rethrow_exception(e.exceptions().front()), std::runtime_error);
+    }
+    EXPECT_NO_THROW(group.wait());
+}
+
+TEST(TaskGroupTest, CancelAllSkipsQueuedTasksAndStopsRunningOnes) {
+    ThreadPool pool(1);
+    TaskGroup group(pool);
+    std::atomic<bool> started{false};
+    std::atomic<int> executed{0};
+
+    group.spawn([&started](const CancellationToken& token) {
+        started = true;
+        while (!token.is_cancellation_requested()) {
+            std::this_thread::sleep_for(1ms);
+        }
+        token.throw_if_cancellation_requested();
+    });
+    for (int i = 0; i < 100; ++i) {
+        group.spawn([&executed]() { executed++; });
+    }
+    while (!started) {
+        std::this_thread::yield();
+    }
+
+    group.cancel_all();
+    group.spawn([&executed]() { executed++; });
+    EXPECT_NO_THROW(group.wait());
+    EXPECT_EQ(executed.load(), 0);
+}
+
+TEST(ExecutorTest, DeducesResultTypesPerSubmit) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    Executor executor(pool, dispatcher);
+
+    Operation<int> number = executor.submit([]() { return 42; });
+    Operation<std::string> text = executor.submit([](const CancellationToken&) { return std::string("done"); });
+
+    EXPECT_EQ(number->getFuture().get(), 42);
+    EXPECT_EQ(text->getFuture().get(), "done");
+}
+
+TEST(ExecutorTest, SupportsVoidResults) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    Executor executor(pool, dispatcher);
+    std::atomic<bool> ran{false};
+    bool called_back = false;
+
+    Operation<void> op = executor.submit([&ran]() { ran = true; }, [&called_back]() { called_back = true; });
+    op->getFuture().get();
+    EXPECT_TRUE(ran);
+
+    while (!called_back) {
+        dispatcher.execute_pending();
+    }
+}
+
+TEST(ExecutorTest, SupportsMoveOnlyResults) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    Executor executor(pool, dispatcher);
+    int seen = 0;
+
+    auto op = executor.submit([]() { return std::make_unique<int>(7); },
+                              [&seen](const std::unique_ptr<int>& value) { seen = *value; });
+
+    EXPECT_EQ(*op->getFuture().get(), 7);
+    while (seen == 0) {
+        dispatcher.execute_pending();
+    }
+    EXPECT_EQ(seen, 7);
+}
+
+TEST(ExecutorTest, SharedByTypedExecutors) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    Executor executor(pool, dispatcher);
+    AsyncExecutor<int> ints(executor);
+    AsyncExecutor<double> doubles(executor);
+
+    EXPECT_EQ(ints.start([]() { return 1; })->getFuture().get(), 1);
+    EXPECT_DOUBLE_EQ(doubles.start([]() { return 2.5; })->getFuture().get(), 2.5);
+}
+
+namespace {
+struct CopyCounter {
+    static inline std::atomic<int> copies{0};
+
+    CopyCounter() = default;
+    CopyCounter(const CopyCounter&) { copies++; }
+    CopyCounter(CopyCounter&&) noexcept = default;
+    CopyCounter& operator=(const CopyCounter&) { copies++; return *this; }
+    CopyCounter& operator=(CopyCounter&&) noexcept = default;
+};
+}
+
+TEST(ExecutorTest, ResultReachesFutureAndCallbackWithoutCopies) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    AsyncExecutor<CopyCounter> executor(pool, dispatcher);
+    bool called_back = false;
+    CopyCounter::copies = 0;
+
+    auto op = executor.start([]() { return CopyCounter(); },
+                             [&called_back](const CopyCounter&) { called_back = true; });
+    const CopyCounter& result = op->getFuture().get();
+    (void)result;
+    while (!called_back) {
+        dispatcher.execute_pending();
+    }
+
+    EXPECT_EQ(CopyCounter::copies.load(), 0);
+}
+
+namespace {
+// Occupies every worker of a pool until opened, so further tasks stay queued.
+struct WorkerGate {
+    std::atomic<bool> open{false};
+
+    void block(ThreadPool& pool, size_t workers) {
+        for (size_t i = 0; i < workers; ++i) {
+            pool.enqueue([this]() {
+                while (!open) {
+                    std::this_thread::sleep_for(1ms);
+                }
+            });
+        }
+        while (pool.get_idle_thread_count() != 0 || pool.get_queued_count() != 0) {
+            std::this_thread::yield();
+        }
+    }
+};
+}
+
+TEST(ThreadPoolBackpressureTest, RejectPolicyRefusesTasksBeyondCapacity) {
+    ThreadPool pool(1, 2, OverflowPolicy::Reject);
+    WorkerGate gate;
+    gate.block(pool, 1);
+
+    std::atomic<int> ran{0};
+    pool.enqueue([&ran]() { ran++; });
+    EXPECT_TRUE(pool.try_enqueue([&ran]() { ran++; }));
+    EXPECT_FALSE(pool.try_enqueue([&ran]() { ran++; }));
+    EXPECT_THROW(pool.enqueue([&ran]() { ran++; }), RejectedExecutionException);
+    EXPECT_EQ(pool.get_queued_count(), 2u);
+
+    gate.open = true;
+    while (ran != 2) {
+        std::this_thread::yield();
+    }
+    EXPECT_TRUE(pool.try_enqueue([&ran]() { ran++; }));
+}
+
+TEST(ThreadPoolBackpressureTest, BlockPolicyWaitsForSpace) {
+    ThreadPool pool(1, 1, OverflowPolicy::Block);
+    WorkerGate gate;
+    gate.block(pool, 1);
+    pool.enqueue([]() {});
+    EXPECT_FALSE(pool.try_enqueue([]() {}));
+
+    std::atomic<bool> enqueued{false};
+    std::thread producer([&pool, &enqueued]() {
+        pool.enqueue([]() {});
+        enqueued = true;
+    });
+    std::this_thread::sleep_for(20ms);
+    EXPECT_FALSE(enqueued);
+
+    gate.open = true;
+    producer.join();
+    EXPECT_TRUE(enqueued);
+}
+
+TEST(ThreadPoolBackpressureTest, DropOldestCancelsDroppedOperations) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1, 2, OverflowPolicy::DropOldest);
+    Executor executor(pool, dispatcher);
+    WorkerGate gate;
+    gate.block(pool, 1);
+
+    auto first = executor.submit([]() { return 1; });
+    auto second = executor.submit([]() { return 2; });
+    auto third = executor.submit([]() { return 3; });
+    EXPECT_TRUE(first->isCancelled());
+    EXPECT_THROW(first->getFuture().get(), OperationCancelledException);
+
+    gate.open = true;
+    EXPECT_EQ(second->getFuture().get(), 2);
+    EXPECT_EQ(third->getFuture().get(), 3);
+}
+
+TEST(ThreadPoolBackpressureTest, DroppedTaskGroupTasksDoNotBlockJoin) {
+    ThreadPool pool(1, 1, OverflowPolicy::DropOldest);
+    WorkerGate gate;
+    gate.block(pool, 1);
+
+    std::atomic<int> ran{0};
+    TaskGroup group(pool);
+    group.spawn([&ran]() { ran++; });
+    group.spawn([&ran]() { ran++; });
+    gate.open = true;
+    group.wait();
+    EXPECT_EQ(ran, 1);
+}
+
+TEST(ThreadPoolBackpressureTest, CallerRunsExecutesOnSubmittingThread) {
+    ThreadPool pool(1, 1, OverflowPolicy::CallerRuns);
+    WorkerGate gate;
+    gate.block(pool, 1);
+    pool.enqueue([]() {});
+
+    std::thread::id ran_on;
+    pool.enqueue([&ran_on]() { ran_on = std::this_thread::get_id(); });
+    EXPECT_EQ(ran_on, std::this_thread::get_id());
+    gate.open = true;
+}
+
+TEST(ThreadPoolBackpressureTest, TryStartReportsRejection) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1, 1, OverflowPolicy::Reject);
+    AsyncExecutor<int> executor(pool, dispatcher);
+    WorkerGate gate;
+    gate.block(pool, 1);
+
+    auto accepted = executor.try_start([]() { return 1; });
+    ASSERT_NE(accepted, nullptr);
+    EXPECT_EQ(executor.try_start([]() { return 2; }), nullptr);
+    EXPECT_THROW(executor.start([]() { return 3; }), RejectedExecutionException);
+
+    gate.open = true;
+    EXPECT_EQ(accepted->getFuture().get(), 1);
+}
+
+TEST(ThreadPoolBackpressureTest, AdmissionControllerShedsOnSojournTime) {
+    // The interval is far longer than the few calls made between detecting
+    // overload and checking for shedding, so no probe falls in between.
+    auto admission = std::make_shared<AdmissionController>(1ms, 100ms);
+    ThreadPool pool(1, 0, OverflowPolicy::Block, admission);
+
+    // Tasks that wait well over the 1ms target for longer than the interval
+    // put the controller into overload, with a backlog still left to run.
+    for (int i = 0; i < 100; ++i) {
+        pool.enqueue([]() { std::this_thread::sleep_for(2ms); });
+    }
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!admission->is_overloaded() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    ASSERT_TRUE(admission->is_overloaded());
+    EXPECT_FALSE(pool.try_enqueue([]() {}));
+    EXPECT_THROW(pool.enqueue([]() {}), RejectedExecutionException);
+    EXPECT_GE(admission->rejected_count(), 2u);
+
+    // Probes are still admitted once per interval; after the backlog has
+    // drained one of them starts within target and ends the overload.
+    deadline = std::chrono::steady_clock::now() + 5s;
+    while (admission->is_overloaded() && std::chrono::steady_clock::now() < deadline) {
+        pool.try_enqueue([]() {});
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_FALSE(admission->is_overloaded());
+    EXPECT_TRUE(pool.try_enqueue([]() {}));
+}
+
+TEST(ExecutionPolicyTest, InlineCallbacksRunOnWorkerWithoutDispatcher) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    ExecutionPolicy policy;
+    policy.bind_callbacks = false;
+    policy.inline_callbacks = true;
+    Executor executor(pool, dispatcher, policy);
+    std::promise<std::thread::id> callback_thread;
+
+    auto op = executor.submit([]() { return std::this_thread::get_id(); },
+                              [&callback_thread](const std::thread::id&) {
+                                  callback_thread.set_value(std::this_thread::get_id());
+                              });
+    std::thread::id worker = op->getFuture().get();
+    auto future = callback_thread.get_future();
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(future.get(), worker);
+    EXPECT_NE(worker, std::this_thread::get_id());
+    EXPECT_FALSE(dispatcher.execute_pending());
+}
+
+TEST(ExecutionPolicyTest, UnboundCallbacksRunOnAnyDispatchingThread) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    Executor executor = Executor(pool, dispatcher).with_policy(ExecutionPolicy{false, false, false});
+    std::atomic<bool> called_back{false};
+
+    auto op = executor.submit([]() { return 1; }, [&called_back](const int&) { called_back = true; });
+    op->getFuture().get();
+    std::thread other([&dispatcher, &called_back]() {
+        while (!called_back) {
+            dispatcher.execute_pending();
+        }
+    });
+    other.join();
+    EXPECT_TRUE(called_back);
+}
+
+TEST(ExecutionPolicyTest, RunInlineIfIdleSkipsThePoolOnlyWhenIdle) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    ExecutionPolicy policy;
+    policy.run_inline_if_idle = true;
+    AsyncExecutor<std::thread::id> executor(pool, dispatcher, policy);
+    bool called_back = false;
+
+    auto inline_op = executor.start([]() { return std::this_thread::get_id(); },
+                                    [&called_back](const std::thread::id&) { called_back = true; });
+    ASSERT_EQ(inline_op->getFuture().wait_for(0s), std::future_status::ready);
+    EXPECT_EQ(inline_op->getFuture().get(), std::this_thread::get_id());
+    // Bound callbacks still go through the dispatcher.
+    EXPECT_FALSE(called_back);
+    EXPECT_TRUE(dispatcher.execute_pending());
+    EXPECT_TRUE(called_back);
+
+    WorkerGate gate;
+    gate.block(pool, 1);
+    auto pooled_op = executor.start([]() { return std::this_thread::get_id(); });
+    EXPECT_EQ(pooled_op->getFuture().wait_for(10ms), std::future_status::timeout);
+    gate.open = true;
+    EXPECT_NE(pooled_op->getFuture().get(), std::this_thread::get_id());
+}
+
+namespace {
+// Opens gate after delay from another thread, so a shutdown that waits for
+// the blocked workers can be started first.
+std::thread open_later(WorkerGate& gate, std::chrono::milliseconds delay) {
+    return std::thread([&gate, delay]() {
+        std::this_thread::sleep_for(delay);
+        gate.open = true;
+    });
+}
+}
+
+TEST(ShutdownTest, DrainRunsQueuedTasksAndTheirFollowUps) {
+    ThreadPool pool(2);
+    WorkerGate gate;
+    gate.block(pool, 2);
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 100; ++i) {
+        pool.enqueue([&pool, &ran]() {
+            ran++;
+            pool.enqueue([&ran]() { ran++; });
+        });
+    }
+
+    std::thread opener = open_later(gate, 20ms);
+    pool.shutdown(ShutdownMode::Drain);
+    opener.join();
+
+    EXPECT_EQ(ran.load(), 200);
+    EXPECT_EQ(pool.get_in_flight_count(), 0u);
+    EXPECT_FALSE(pool.is_accepting());
+    EXPECT_THROW(pool.enqueue([]() {}), RejectedExecutionException);
+}
+
+TEST(ShutdownTest, CancelPendingDropsQueuedTasks) {
+    ThreadPool pool(1);
+    WorkerGate gate;
+    gate.block(pool, 1);
+    std::atomic<int> ran{0};
+    std::atomic<int> dropped{0};
+    for (int i = 0; i < 50; ++i) {
+        pool.enqueue(pool.guard_drop([&ran]() { ran++; }, [&dropped]() { dropped++; }));
+    }
+
+    std::thread opener = open_later(gate, 20ms);
+    pool.shutdown(ShutdownMode::CancelPending);
+    opener.join();
+
+    EXPECT_EQ(ran.load(), 0);
+    EXPECT_EQ(dropped.load(), 50);
+}
+
+TEST(ShutdownTest, DeadlineDrainStopsDrainingAtTheTimeout) {
+    ThreadPool pool(1);
+    std::atomic<int> ran{0};
+    std::atomic<int> dropped{0};
+    for (int i = 0; i < 100; ++i) {
+        pool.enqueue(pool.guard_drop([&ran]() {
+            std::this_thread::sleep_for(5ms);
+            ran++;
+        }, [&dropped]() { dropped++; }));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pool.shutdown(ShutdownMode::DeadlineDrain, 50ms);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_LT(elapsed, 300ms);
+    EXPECT_GT(ran.load(), 0);
+    EXPECT_GT(dropped.load(), 0);
+    EXPECT_EQ(ran.load() + dropped.load(), 100);
+}
+
+TEST(ShutdownTest, WaitIdleWaitsForQueuedAndRunningTasks) {
+    ThreadPool pool(4);
+    WorkerGate gate;
+    gate.block(pool, 4);
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 200; ++i) {
+        pool.enqueue([&ran]() { ran++; });
+    }
+    EXPECT_EQ(pool.get_in_flight_count(), 204u);
+    EXPECT_FALSE(pool.wait_idle_for(10ms));
+
+    gate.open = true;
+    pool.wait_idle();
+    EXPECT_EQ(ran.load(), 200);
+    EXPECT_EQ(pool.get_in_flight_count(), 0u);
+    EXPECT_TRUE(pool.is_idle());
+}
+
+TEST(ShutdownTest, CancelPendingCancelsExecutorOperations) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    AsyncExecutor<int> executor(pool, dispatcher);
+    WorkerGate gate;
+    gate.block(pool, 1);
+    std::vector<std::shared_ptr<CancellableOperation<int>>> operations;
+    for (int i = 0; i < 10; ++i) {
+        operations.push_back(executor.start([i]() { return i; }));
+    }
+
+    std::thread opener = open_later(gate, 20ms);
+    executor.shutdown(ShutdownMode::CancelPending);
+    opener.join();
+
+    for (auto& op : operations) {
+        auto future = op->getFuture();
+        ASSERT_EQ(future.wait_for(0s), std::future_status::ready);
+        EXPECT_THROW(future.get(), OperationCancelledException);
+    }
+    EXPECT_TRUE(dispatcher.is_stopped());
+}
+
+TEST(ShutdownTest, DrainCompletesOperationsAndDeliversCallbacks) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    AsyncExecutor<int> executor(pool, dispatcher);
+    std::atomic<int> called_back{0};
+    std::vector<std::shared_ptr<CancellableOperation<int>>> operations;
+    for (int i = 0; i < 20; ++i) {
+        operations.push_back(executor.start([i]() {
+            std::this_thread::sleep_for(1ms);
+            return i;
+        }, [&called_back](const int&) { called_back++; }));
+    }
+
+    executor.shutdown();
+
+    EXPECT_EQ(called_back.load(), 20);
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(operations[i]->getFuture().get(), i);
+    }
+    EXPECT_THROW(executor.start([]() { return 0; }), RejectedExecutionException);
+}
@@ -0,0 +1,207 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "AsyncFileIO.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+AsyncFileIO::Buffer to_buffer(const std::string& text) {
+    AsyncFileIO::Buffer buffer(text.size());
+    std::memcpy(buffer.data(), text.data(), text.size());
+    return buffer;
+}
+
+std::string to_string(const AsyncFileIO::Buffer& buffer) {
+    return std::string(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+class AsyncFileIOTest : public ::testing::TestWithParam<AsyncFileIO::Backend> {
+protected:
+    void SetUp() override {
+        char path[] = "/tmp/async_file_io_XXXXXX";
+        int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        m_path = path;
+    }
+
+    void TearDown() override {
+        unlink(m_path.c_str());
+    }
+
+    std::string m_path;
+};
+
+}
+
+TEST_P(AsyncFileIOTest, WriteSyncAndReadBack) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    Executor executor(pool, dispatcher);
+    AsyncFileIO files(executor, 64, GetParam());
+
+    int fd = files.open(m_path, O_RDWR)->getFuture().get();
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(files.write_at(fd, to_buffer("hello world"), 0)->getFuture().get(), 11u);
+    files.fsync(fd)->getFuture().get();
+
+    EXPECT_EQ(to_string(files.read_at(fd, 5, 6)->getFuture().get()), "world");
+    EXPECT_TRUE(files.read_at(fd, 16, 100)->getFuture().get().empty());
+
+    std::atomic<bool> called(false);
+    auto op = files.read_at(fd, 5, 0, [&called](const AsyncFileIO::Buffer& buffer) {
+        called = to_string(buffer) == "hello";
+    });
+    op->getFuture().wait();
+    while (!called) {
+        dispatcher.execute_pending();
+    }
+    close(fd);
+}
+
+TEST_P(AsyncFileIOTest, ErrorsReachTheFuture) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    Executor executor(pool, dispatcher);
+    AsyncFileIO files(executor, 8, GetParam());
+
+    std::atomic<bool> reported(false);
+    auto op = files.open(m_path + ".missing/file", O_RDONLY, 0644, std::nullopt,
+                         [&reported](const std::string&) { reported = true; });
+    EXPECT_THROW(op->getFuture().get(), std::system_error);
+    EXPECT_TRUE(reported);
+}
+
+TEST_P(AsyncFileIOTest, RejectsTransfersBeyondMaxTransfer) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    Executor executor(pool, dispatcher);
+    AsyncFileIO files(executor, 8, GetParam());
+
+    int fd = ::open(m_path.c_str(), O_RDWR);
+    // 4 GiB would wrap to an empty read in the 32-bit sqe length.
+    EXPECT_THROW(files.read_at(fd, std::size_t(1) << 32, 0), std::invalid_argument);
+    EXPECT_THROW(files.read_at(fd, AsyncFileIO::MaxTransfer + 1, 0), std::invalid_argument);
+    EXPECT_TRUE(files.read_at(fd, 16, 0)->getFuture().get().empty());
+    close(fd);
+}
+
+TEST_P(AsyncFileIOTest, ManyReadsInFlightBeyondQueueDepth) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    Executor executor(pool, dispatcher);
+    AsyncFileIO files(executor, 16, GetParam());
+
+    int fd = ::open(m_path.c_str(), O_RDWR);
+    std::string contents;
+    for (int i = 0; i < 1000; ++i) {
+        contents += static_cast<char>('a' + i % 26);
+    }
+    ASSERT_EQ(pwrite(fd, contents.data(), contents.size(), 0), static_cast<ssize_t>(contents.size()));
+
+    std::vector<Operation<AsyncFileIO::Buffer>> reads;
+    for (int i = 0; i < 1000; ++i) {
+        reads.push_back(files.read_at(fd, 1, i));
+    }
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(to_string(reads[i]->getFuture().get()), std::string(1, contents[i]));
+    }
+    close(fd);
+}
+
+TEST_P(AsyncFileIOTest, CancelledReadsReportCancellation) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    Executor executor(pool, dispatcher);
+    AsyncFileIO files(executor, 8, GetParam());
+
+    // Keeps the only pool thread busy, so thread pool reads stay queued.
+    std::atomic<bool> release(false);
+    pool.enqueue([&release]() {
+        while (!release) {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+
+    // Nothing is written to the pipe, so io_uring reads stay in flight
+    // until they are cancelled.
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    CancellationSource source;
+    auto op = files.read_at(fds[0], 16, -1, std::nullopt, std::nullopt, source.get_token());
+    std::this_thread::sleep_for(10ms);
+    source.request_cancellation();
+    EXPECT_THROW(op->getFuture().get(), OperationCancelledException);
+
+    if (GetParam() == AsyncFileIO::Backend::IoUring) {
+        auto pending = files.read_at(fds[0], 16, -1);
+        files.stop();
+        EXPECT_THROW(pending->getFuture().get(), OperationCancelledException);
+    }
+    release = true;
+    close(fds[0]);
+    close(fds[1]);
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, AsyncFileIOTest,
+                         ::testing::Values(AsyncFileIO::Backend::IoUring, AsyncFileIO::Backend::ThreadPool));
+
+TEST(AsyncFileIOBackendTest, UsesIoUringWhenAvailable) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    Executor executor(pool, dispatcher);
+    AsyncFileIO files(executor);
+    AsyncFileIO fallback(executor, 8, AsyncFileIO::Backend::ThreadPool);
+    EXPECT_EQ(fallback.backend(), AsyncFileIO::Backend::ThreadPool);
+    if (files.backend() != AsyncFileIO::Backend::IoUring) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+}
+
+// Every read is cancelled while the ring is full, so the cancels and their
+// completions have to share the ring with the reads.
+TEST(AsyncFileIOBackendTest, CancelsBeyondQueueDepthAndStopsInTime) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    Executor executor(pool, dispatcher);
+    AsyncFileIO files(executor, 4);
+    if (files.backend() != AsyncFileIO::Backend::IoUring) {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    CancellationSource source;
+    std::vector<Operation<AsyncFileIO::Buffer>> reads;
+    for (int i = 0; i < 64; ++i) {
+        reads.push_back(files.read_at(fds[0], 16, -1, std::nullopt, std::nullopt, source.get_token()));
+    }
+    source.request_cancellation();
+    for (auto& read : reads) {
+        EXPECT_THROW(read->getFuture().get(), OperationCancelledException);
+    }
+
+    std::vector<Operation<AsyncFileIO::Buffer>> pending;
+    for (int i = 0; i < 64; ++i) {
+        pending.push_back(files.read_at(fds[0], 16, -1));
+    }
+    auto start = std::chrono::steady_clock::now();
+    files.stop(200ms);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+    for (auto& read : pending) {
+        EXPECT_THROW(read->getFuture().get(), OperationCancelledException);
+    }
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,254 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "AsyncEvent.h"
+#include "AsyncLatch.h"
+#include "AsyncMutex.h"
+#include "ThreadPool.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+template<typename Predicate>
+bool wait_until(Predicate predicate, std::chrono::milliseconds timeout = 5000ms) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!predicate()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(1ms);
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(AsyncMutexTest, WaitersAcquireInOrder) {
+    ThreadPool pool(1);
+    AsyncMutex mutex(pool);
+    std::vector<int> order;
+
+    ASSERT_TRUE(mutex.try_lock());
+    for (int i = 0; i < 5; ++i) {
+        mutex.lock([&mutex, &order, i]() {
+            order.push_back(i);
+            mutex.unlock();
+        });
+    }
+    EXPECT_TRUE(order.empty());
+
+    mutex.unlock();
+    ASSERT_TRUE(wait_until([&mutex]() { return !mutex.is_locked(); }));
+    EXPECT_EQ(order, std::vector<int>({0, 1, 2, 3, 4}));
+}
+
+TEST(AsyncMutexTest, ContendedLocksDoNotParkWorkers) {
+    ThreadPool pool(2);
+    AsyncMutex mutex(pool);
+    const int tasks = 200;
+    std::atomic<int> inside{0};
+    std::atomic<bool> overlapped{false};
+    std::atomic<int> done{0};
+    int counter = 0;
+
+    for (int i = 0; i < tasks; ++i) {
+        pool.enqueue([&]() {
+            mutex.run_locked([&]() {
+                if (++inside > 1) {
+                    overlapped = true;
+                }
+                ++counter;
+                --inside;
+                ++done;
+            });
+        });
+    }
+
+    ASSERT_TRUE(wait_until([&done]() { return done.load() == tasks; }));
+    EXPECT_FALSE(overlapped);
+    EXPECT_EQ(counter, tasks);
+    // Waiting for the lock never occupied a worker.
+    ASSERT_TRUE(wait_until([&pool]() { return pool.get_idle_thread_count() == 2; }));
+}
+
+TEST(AsyncMutexTest, CancelledWaiterIsSkipped) {
+    ThreadPool pool(1);
+    AsyncMutex mutex(pool);
+    CancellationSource source;
+    std::atomic<bool> cancelled_ran{false};
+    std::promise<void> other_ran;
+
+    ASSERT_TRUE(mutex.try_lock());
+    mutex.lock([&cancelled_ran]() { cancelled_ran = true; }, source.get_token());
+    mutex.lock([&mutex, &other_ran]() {
+        mutex.unlock();
+        other_ran.set_value();
+    });
+    source.request_cancellation();
+    mutex.unlock();
+
+    ASSERT_EQ(other_ran.get_future().wait_for(5s), std::future_status::ready);
+    EXPECT_FALSE(cancelled_ran);
+    EXPECT_FALSE(mutex.is_locked());
+}
+
+TEST(AsyncSharedMutexTest, ReadersShareAndWritersExclude) {
+    ThreadPool pool(4);
+    AsyncSharedMutex mutex(pool);
+    std::atomic<int> readers{0};
+    std::atomic<int> writers{0};
+    std::atomic<int> peak_readers{0};
+    std::atomic<bool> violated{false};
+    std::atomic<int> done{0};
+    const int tasks = 200;
+
+    for (int i = 0; i < tasks; ++i) {
+        pool.enqueue([&, i]() {
+            if (i % 10 == 0) {
+                mutex.run_locked([&]() {
+                    if (++writers > 1 || readers.load() > 0) {
+                        violated = true;
+                    }
+                    std::this_thread::sleep_for(100us);
+                    --writers;
+                    ++done;
+                });
+            } else {
+                mutex.run_shared([&]() {
+                    int now = ++readers;
+                    int seen = peak_readers.load();
+                    while (now > seen && !peak_readers.compare_exchange_weak(seen, now)) {
+                    }
+                    if (writers.load() > 0) {
+                        violated = true;
+                    }
+                    std::this_thread::sleep_for(100us);
+                    --readers;
+                    ++done;
+                });
+            }
+        });
+    }
+
+    ASSERT_TRUE(wait_until([&done]() { return done.load() == tasks; }));
+    EXPECT_FALSE(violated);
+    EXPECT_GT(peak_readers.load(), 1);
+}
+
+TEST(AsyncSharedMutexTest, WaitingWriterHoldsBackNewReaders) {
+    ThreadPool pool(1);
+    AsyncSharedMutex mutex(pool);
+    std::mutex order_mutex;
+    std::vector<char> order;
+    auto record = [&order_mutex, &order](char c) {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order.push_back(c);
+    };
+
+    ASSERT_TRUE(mutex.try_lock_shared());
+    mutex.lock([&]() { record('w'); mutex.unlock(); });
+    EXPECT_FALSE(mutex.try_lock_shared());
+    std::promise<void> reader_ran;
+    mutex.lock_shared([&]() { record('r'); mutex.unlock_shared(); reader_ran.set_value(); });
+
+    mutex.unlock_shared();
+    ASSERT_EQ(reader_ran.get_future().wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(order, std::vector<char>({'w', 'r'}));
+}
+
+TEST(AsyncSharedMutexTest, CancelledWriterReleasesQueuedReaders) {
+    ThreadPool pool(1);
+    AsyncSharedMutex mutex(pool);
+    CancellationSource source;
+    std::promise<void> reader_ran;
+
+    ASSERT_TRUE(mutex.try_lock_shared());
+    mutex.lock([]() { FAIL() << "cancelled writer ran"; }, source.get_token());
+    mutex.lock_shared([&]() { mutex.unlock_shared(); reader_ran.set_value(); });
+
+    source.request_cancellation();
+    ASSERT_EQ(reader_ran.get_future().wait_for(5s), std::future_status::ready);
+    mutex.unlock_shared();
+    EXPECT_TRUE(mutex.try_lock());
+}
+
+TEST(AsyncLatchTest, WaitersResumeWhenCountReachesZero) {
+    ThreadPool pool(2);
+    AsyncLatch latch(pool, 3);
+    std::atomic<int> resumed{0};
+
+    latch.wait([&resumed]() { ++resumed; });
+    latch.wait([&resumed]() { ++resumed; });
+    latch.count_down();
+    latch.count_down();
+    EXPECT_FALSE(latch.try_wait());
+    EXPECT_EQ(resumed.load(), 0);
+
+    latch.count_down();
+    EXPECT_TRUE(latch.try_wait());
+    ASSERT_TRUE(wait_until([&resumed]() { return resumed.load() == 2; }));
+
+    bool inline_ran = false;
+    latch.wait([&inline_ran]() { inline_ran = true; });
+    EXPECT_TRUE(inline_ran);
+    EXPECT_THROW(latch.count_down(), std::logic_error);
+}
+
+TEST(AsyncBarrierTest, PhasesCompleteWhenAllParticipantsArrive) {
+    ThreadPool pool(2);
+    std::atomic<int> completions{0};
+    AsyncBarrier barrier(pool, 3, [&completions]() { ++completions; });
+    std::atomic<int> resumed{0};
+
+    for (size_t phase = 0; phase < 3; ++phase) {
+        barrier.arrive_and_wait([&resumed]() { ++resumed; });
+        barrier.arrive_and_wait([&resumed]() { ++resumed; });
+        EXPECT_EQ(barrier.phase(), phase);
+        barrier.arrive_and_wait([&resumed]() { ++resumed; });
+        EXPECT_EQ(barrier.phase(), phase + 1);
+    }
+    EXPECT_EQ(completions.load(), 3);
+    ASSERT_TRUE(wait_until([&resumed]() { return resumed.load() == 9; }));
+
+    barrier.arrive_and_wait([&resumed]() { ++resumed; });
+    barrier.arrive_and_wait([&resumed]() { ++resumed; });
+    barrier.arrive_and_drop();
+    EXPECT_EQ(barrier.phase(), 4u);
+    barrier.arrive_and_wait([&resumed]() { ++resumed; });
+    barrier.arrive_and_wait([&resumed]() { ++resumed; });
+    EXPECT_EQ(barrier.phase(), 5u);
+    ASSERT_TRUE(wait_until([&resumed]() { return resumed.load() == 13; }));
+}
+
+TEST(AsyncEventTest, SetResumesWaitersAndResetRearms) {
+    ThreadPool pool(2);
+    AsyncEvent event(pool);
+    CancellationSource source;
+    std::atomic<int> resumed{0};
+    std::atomic<bool> cancelled_ran{false};
+
+    event.wait([&resumed]() { ++resumed; });
+    event.wait([&resumed]() { ++resumed; });
+    event.wait([&cancelled_ran]() { cancelled_ran = true; }, source.get_token());
+    source.request_cancellation();
+    EXPECT_FALSE(event.is_set());
+
+    event.set();
+    ASSERT_TRUE(wait_until([&resumed]() { return resumed.load() == 2; }));
+    bool inline_ran = false;
+    event.wait([&inline_ran]() { inline_ran = true; });
+    EXPECT_TRUE(inline_ran);
+
+    event.reset();
+    event.wait([&resumed]() { ++resumed; });
+    std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(resumed.load(), 2);
+    event.set();
+    ASSERT_TRUE(wait_until([&resumed]() { return resumed.load() == 3; }));
+    EXPECT_FALSE(cancelled_ran);
+}
@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "CallbackDispatcher.h"
+#include "EpollReactor.h"
+#include "Executor.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+bool is_readable(int fd, int timeout_ms = 0) {
+    pollfd pfd{fd, POLLIN, 0};
+    return poll(&pfd, 1, timeout_ms) == 1 && (pfd.revents & POLLIN);
+}
+
+EpollReactor::Buffer to_buffer(const std::string& text) {
+    EpollReactor::Buffer buffer(text.size());
+    std::memcpy(buffer.data(), text.data(), text.size());
+    return buffer;
+}
+
+std::string to_string(const EpollReactor::Buffer& buffer) {
+    return std::string(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+}
+
+template<typename Predicate>
+void pump_until(CallbackDispatcher& dispatcher, Predicate predicate) {
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!predicate() && std::chrono::steady_clock::now() < deadline) {
+        dispatcher.execute_pending();
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+}
+
+TEST(CallbackDispatcherEventFdTest, SignalsOnlyOnEmptyToNonEmptyTransition) {
+    CallbackDispatcher dispatcher(CallbackDispatcher::NotificationMode::EventFd);
+    int fd = dispatcher.native_handle();
+    ASSERT_GE(fd, 0);
+    EXPECT_FALSE(is_readable(fd));
+
+    int executed = 0;
+    for (int i = 0; i < 3; ++i) {
+        dispatcher.post([&executed]() { executed++; });
+    }
+    ASSERT_TRUE(is_readable(fd));
+    std::uint64_t counter = 0;
+    ASSERT_EQ(read(fd, &counter, sizeof(counter)), static_cast<ssize_t>(sizeof(counter)));
+    EXPECT_EQ(counter, 1u);
+
+    dispatcher.post([&executed]() { executed++; });
+    EXPECT_FALSE(is_readable(fd));
+
+    EXPECT_TRUE(dispatcher.execute_pending());
+    EXPECT_EQ(executed, 4);
+    EXPECT_FALSE(is_readable(fd));
+    EXPECT_FALSE(dispatcher.has_pending_tasks());
+}
+
+TEST(CallbackDispatcherEventFdTest, RearmsWhenTasksRemain) {
+    CallbackDispatcher dispatcher(CallbackDispatcher::NotificationMode::EventFd);
+    int executed = 0;
+    dispatcher.post([&executed]() { executed++; });
+    dispatcher.post([&executed]() { executed++; });
+
+    dispatcher.execute_pending(1);
+    EXPECT_EQ(executed, 1);
+    EXPECT_TRUE(is_readable(dispatcher.native_handle()));
+
+    dispatcher.execute_pending();
+    EXPECT_EQ(executed, 2);
+    EXPECT_FALSE(is_readable(dispatcher.native_handle()));
+}
+
+TEST(CallbackDispatcherEventFdTest, ThrowingTaskStillLeavesThePendingCount) {
+    CallbackDispatcher dispatcher(CallbackDispatcher::NotificationMode::EventFd);
+    int executed = 0;
+    dispatcher.post([]() { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(dispatcher.execute_pending(), std::runtime_error);
+    EXPECT_FALSE(dispatcher.has_pending_tasks());
+    EXPECT_FALSE(is_readable(dispatcher.native_handle()));
+
+    dispatcher.post([&executed]() { executed++; });
+    EXPECT_TRUE(is_readable(dispatcher.native_handle()));
+    EXPECT_TRUE(dispatcher.execute_pending());
+    EXPECT_EQ(executed, 1);
+    EXPECT_FALSE(dispatcher.has_pending_tasks());
+    EXPECT_FALSE(is_readable(dispatcher.native_handle()));
+}
+
+TEST(CallbackDispatcherEventFdTest, CallbacksForOtherThreadsDoNotKeepTheOwnerAwake) {
+    CallbackDispatcher dispatcher(CallbackDispatcher::NotificationMode::EventFd);
+    std::atomic<bool> drain(false);
+    std::atomic<bool> foreign_ran(false);
+    std::thread other([&dispatcher, &drain]() {
+        while (!drain) {
+            std::this_thread::sleep_for(1ms);
+        }
+        dispatcher.execute_pending();
+    });
+
+    int executed = 0;
+    dispatcher.post([&foreign_ran]() { foreign_ran = true; }, other.get_id());
+    dispatcher.post([&executed]() { executed++; });
+    ASSERT_TRUE(is_readable(dispatcher.native_handle()));
+    EXPECT_TRUE(dispatcher.execute_pending());
+    EXPECT_EQ(executed, 1);
+    EXPECT_TRUE(dispatcher.has_pending_tasks());
+    EXPECT_FALSE(is_readable(dispatcher.native_handle()));
+
+    // The owner is still woken for its own callbacks.
+    dispatcher.post([&executed]() { executed++; });
+    ASSERT_TRUE(is_readable(dispatcher.native_handle()));
+    EXPECT_TRUE(dispatcher.execute_pending());
+    EXPECT_EQ(executed, 2);
+    EXPECT_FALSE(is_readable(dispatcher.native_handle()));
+
+    drain = true;
+    other.join();
+    EXPECT_TRUE(foreign_ran);
+    EXPECT_FALSE(dispatcher.has_pending_tasks());
+}
+
+TEST(CallbackDispatcherEventFdTest, OwnerEpollLoopReceivesCallbacks) {
+    CallbackDispatcher dispatcher(CallbackDispatcher::NotificationMode::EventFd);
+    ThreadPool pool(2);
+    Executor executor(pool, dispatcher);
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = dispatcher.native_handle();
+    ASSERT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, dispatcher.native_handle(), &event), 0);
+
+    int results = 0;
+    for (int i = 0; i < 10; ++i) {
+        executor.submit([i]() { return i; }, [&results](const int&) { results++; });
+    }
+    while (results < 10) {
+        epoll_event ready{};
+        ASSERT_EQ(epoll_wait(epoll_fd, &ready, 1, 5000), 1);
+        dispatcher.execute_pending();
+    }
+    close(epoll_fd);
+    EXPECT_EQ(results, 10);
+}
+
+TEST(EpollReactorTest, ReadCompletesWhenPipeBecomesReadable) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    Executor executor(pool, dispatcher);
+    EpollReactor reactor(executor);
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    std::string received;
+    auto op = reactor.async_read(fds[0], 64, [&received](const EpollReactor::Buffer& buffer) {
+        received = to_string(buffer);
+    });
+    std::this_thread::sleep_for(10ms);
+    EXPECT_EQ(op->getFuture().wait_for(0s), std::future_status::timeout);
+
+    ASSERT_EQ(write(fds[1], "hello", 5), 5);
+    EXPECT_EQ(to_string(op->getFuture().get()), "hello");
+    pump_until(dispatcher, [&received]() { return !received.empty(); });
+    EXPECT_EQ(received, "hello");
+
+    close(fds[1]);
+    EXPECT_TRUE(reactor.async_read(fds[0], 64)->getFuture().get().empty());
+    close(fds[0]);
+}
+
+TEST(EpollReactorTest, InlineCallbacksRunWithoutTheDispatcher) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    ExecutionPolicy policy;
+    policy.bind_callbacks = false;
+    policy.inline_callbacks = true;
+    Executor executor(pool, dispatcher, policy);
+    EpollReactor reactor(executor);
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    std::atomic<bool> received(false);
+    auto op = reactor.async_read(fds[0], 64, [&received](const EpollReactor::Buffer& buffer) {
+        received = to_string(buffer) == "hello";
+    });
+    ASSERT_EQ(write(fds[1], "hello", 5), 5);
+    EXPECT_EQ(to_string(op->getFuture().get()), "hello");
+    auto deadline = std::chrono::steady_clock::now() + 5s;
+    while (!received && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_TRUE(received);
+    EXPECT_FALSE(dispatcher.has_pending_tasks());
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(EpollReactorTest, SocketPairEchoWithoutPoolThreads) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    Executor executor(pool, dispatcher);
+    EpollReactor reactor(executor);
+    int sockets[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+
+    // Many concurrent reads on distinct sockets would each need a pool
+    // thread if done with blocking I/O; here the single worker stays idle.
+    auto read_op = reactor.async_read(sockets[1], 1024);
+    auto write_op = reactor.async_write(sockets[0], to_buffer("ping"));
+    EXPECT_EQ(write_op->getFuture().get(), 4u);
+    EXPECT_EQ(to_string(read_op->getFuture().get()), "ping");
+    EXPECT_EQ(pool.get_idle_thread_count(), 1u);
+
+    close(sockets[0]);
+    close(sockets[1]);
+}
+
+TEST(EpollReactorTest, CancelledReadLeavesInterestSet) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1);
+    Executor executor(pool, dispatcher);
+    EpollReactor reactor(executor);
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    auto op = reactor.async_read(fds[0], 64);
+    op->cancel();
+    EXPECT_THROW(op->getFuture().get(), OperationCancelledException);
+
+    // The slot is free again, so a new read can be registered.
+    auto next = reactor.async_read(fds[0], 64);
+    ASSERT_EQ(write(fds[1], "x", 1), 1);
+    EXPECT_EQ(to_string(next->getFuture().get()), "x");
+
+    auto pending = reactor.async_read(fds[0], 64);
+    reactor.stop();
+    EXPECT_THROW(pending->getFuture().get(), OperationCancelledException);
+    close(fds[0]);
+    close(fds[1]);
+}
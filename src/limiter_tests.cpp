@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "AsyncExecutor.h"
+#include "AsyncSemaphore.h"
+#include "Executor.h"
+#include "RateLimiter.h"
+#include "TimerQueue.h"
+
+using namespace std::chrono_literals;
+
+TEST(AsyncSemaphoreTest, ContinuationsWaitForReleasedPermits) {
+    AsyncSemaphore semaphore(1);
+    std::vector<int> order;
+
+    semaphore.acquire([&order]() { order.push_back(1); });
+    semaphore.acquire([&order]() { order.push_back(2); });
+    semaphore.acquire([&order]() { order.push_back(3); });
+    EXPECT_EQ(order, std::vector<int>({1}));
+    EXPECT_EQ(semaphore.waiting(), 2u);
+    EXPECT_FALSE(semaphore.try_acquire());
+
+    semaphore.release();
+    EXPECT_EQ(order, std::vector<int>({1, 2}));
+    semaphore.release(2);
+    EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+    EXPECT_EQ(semaphore.available(), 1u);
+}
+
+TEST(AsyncSemaphoreTest, CancelledWaitersAreSkipped) {
+    AsyncSemaphore semaphore(0);
+    CancellationSource source;
+    bool cancelled_ran = false;
+    bool other_ran = false;
+
+    semaphore.acquire([&cancelled_ran]() { cancelled_ran = true; }, source.get_token());
+    semaphore.acquire([&other_ran]() { other_ran = true; });
+    source.request_cancellation();
+    EXPECT_EQ(semaphore.waiting(), 1u);
+
+    semaphore.release();
+    EXPECT_FALSE(cancelled_ran);
+    EXPECT_TRUE(other_ran);
+}
+
+TEST(AsyncSemaphoreTest, LimitsInFlightOperationsWithoutBlockingWorkers) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(8);
+    AsyncExecutor<int> executor(pool, dispatcher);
+    AsyncSemaphore semaphore(2);
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+
+    std::vector<Operation<int>> ops;
+    for (int i = 0; i < 20; ++i) {
+        ops.push_back(executor.start_limited(semaphore, [i, &running, &peak]() {
+            int now = ++running;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+            }
+            std::this_thread::sleep_for(2ms);
+            --running;
+            return i;
+        }));
+    }
+    // Waiting operations are held by the semaphore, not parked on workers.
+    EXPECT_GE(pool.get_idle_thread_count(), 6u);
+
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(ops[i]->getFuture().get(), i);
+    }
+    EXPECT_LE(peak.load(), 2);
+    // Permits are released right after each future is satisfied.
+    while (semaphore.available() != 2) {
+        std::this_thread::yield();
+    }
+}
+
+TEST(AsyncSemaphoreTest, CancellingLimitedOperationReleasesNoPermit) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    Executor executor(pool, dispatcher);
+    AsyncSemaphore semaphore(0);
+
+    auto op = executor.submit_limited(semaphore, []() { return 1; });
+    op->cancel();
+    EXPECT_THROW(op->getFuture().get(), OperationCancelledException);
+    EXPECT_EQ(semaphore.waiting(), 0u);
+    EXPECT_EQ(semaphore.available(), 0u);
+}
+
+// Every waiter is refused by the full pool and hands its permit on from
+// inside the release that resumed it.
+TEST(AsyncSemaphoreTest, RefusedLimitedOperationsHandPermitsOnWithoutNesting) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(1, 1, OverflowPolicy::Reject);
+    Executor executor(pool, dispatcher);
+    AsyncSemaphore semaphore(1);
+
+    std::atomic<bool> open(false);
+    pool.enqueue([&open]() {
+        while (!open) {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+    while (pool.get_idle_thread_count() != 0) {
+        std::this_thread::yield();
+    }
+    pool.enqueue([]() {});
+
+    ASSERT_TRUE(semaphore.try_acquire());
+    const size_t count = 200000;
+    std::vector<Operation<int>> ops;
+    for (size_t i = 0; i < count; ++i) {
+        ops.push_back(executor.submit_limited(semaphore, []() { return 1; }));
+    }
+    EXPECT_EQ(semaphore.waiting(), count);
+    semaphore.release();
+    EXPECT_EQ(semaphore.waiting(), 0u);
+    EXPECT_EQ(semaphore.available(), 1u);
+    for (auto& op : ops) {
+        EXPECT_TRUE(op->isCancelled());
+    }
+
+    open = true;
+    pool.wait_idle();
+    EXPECT_EQ(executor.submit_limited(semaphore, []() { return 2; })->getFuture().get(), 2);
+}
+
+TEST(TimerQueueTest, RunsCallbacksInDeadlineOrder) {
+    TimerQueue timers;
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic<int> done{0};
+    auto record = [&](int value) {
+        return [&, value]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(value);
+            done++;
+        };
+    };
+
+    timers.schedule_after(20ms, record(3));
+    timers.schedule_after(5ms, record(1));
+    timers.schedule_after(10ms, record(2));
+    while (done != 3) {
+        std::this_thread::sleep_for(1ms);
+    }
+    EXPECT_EQ(order, std::vector<int>({1, 2, 3}));
+}
+
+TEST(RateLimiterTest, AllowsBurstThenPacesWaiters) {
+    TimerQueue timers;
+    RateLimiter limiter(timers, 200.0, 2.0);
+    std::atomic<int> admitted{0};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 6; ++i) {
+        limiter.acquire([&admitted]() { admitted++; });
+    }
+    EXPECT_EQ(admitted, 2);
+    EXPECT_EQ(limiter.waiting(), 4u);
+
+    while (admitted != 6) {
+        std::this_thread::sleep_for(1ms);
+    }
+    // Four more tokens at 200/s take at least ~20ms to accrue.
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 15ms);
+    EXPECT_FALSE(limiter.try_acquire());
+}
+
+TEST(RateLimiterTest, RejectsRatesAndBurstsThatNeverRefill) {
+    TimerQueue timers;
+    EXPECT_THROW(RateLimiter(timers, 0.0, 1.0), std::invalid_argument);
+    EXPECT_THROW(RateLimiter(timers, -5.0, 1.0), std::invalid_argument);
+    EXPECT_THROW(RateLimiter(timers, std::nan(""), 1.0), std::invalid_argument);
+    EXPECT_THROW(RateLimiter(timers, 10.0, 0.5), std::invalid_argument);
+    EXPECT_THROW(RateLimiter(timers, 10.0, std::nan("")), std::invalid_argument);
+
+    RateLimiter limiter(timers, 10.0, 1.0);
+    EXPECT_TRUE(limiter.try_acquire());
+}
+
+TEST(RateLimiterTest, LimitsExecutorSubmissions) {
+    CallbackDispatcher dispatcher;
+    ThreadPool pool(2);
+    Executor executor(pool, dispatcher);
+    TimerQueue timers;
+    RateLimiter limiter(timers, 1000.0, 1.0);
+
+    std::vector<Operation<int>> ops;
+    for (int i = 0; i < 10; ++i) {
+        ops.push_back(executor.submit_limited(limiter, [i]() { return i; }));
+    }
+    CancellationSource source;
+    auto cancelled = executor.submit_limited(limiter, []() { return -1; }, std::nullopt, std::nullopt,
+                                             source.get_token());
+    source.request_cancellation();
+
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(ops[i]->getFuture().get(), i);
+    }
+    EXPECT_THROW(cancelled->getFuture().get(), OperationCancelledException);
+}
@@ -9,6 +9,7 @@
 #include "LockFreeQueue.h"
 #include "LockFreeList.h"
 #include "LockFreeStack.h"
+#include "LockFreeTaskQueue.h"
 
 const int NUM_THREADS = 4;
 const int OPERATIONS_PER_THREAD = 10000;
@@ -208,6 +209,158 @@ TEST(LockFreeStackTest, LIFOOrder) {
     }
 }
 
+// Test for LockFreeTaskQueue: parked consumers wake on push and drain on stop
+TEST(LockFreeTaskQueueTest, BlockingPopAndDrainOnStop) {
+    LockFreeTaskQueue queue;
+    std::atomic<int> executed{0};
+    std::vector<std::thread> consumers;
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        consumers.emplace_back([&queue]() {
+            LockFreeTaskQueue::Task task;
+            while (queue.pop(task)) {
+                task();
+            }
+        });
+    }
+
+    for (int i = 0; i < OPERATIONS_PER_THREAD; ++i) {
+        queue.push([&executed]() { executed.fetch_add(1); });
+        if (i % 1000 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    queue.stop();
+
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    EXPECT_EQ(executed.load(), OPERATIONS_PER_THREAD);
+    EXPECT_TRUE(queue.is_empty());
+}
+
+// Container policies: inline storage needs a trivially copyable payload
+static_assert(ContainerPolicyFor<MessageContainerPolicy, int>);
+static_assert(ContainerPolicyFor<MessageContainerPolicy, void*>);
+static_assert(!ContainerPolicyFor<MessageContainerPolicy, std::string>);
+static_assert(ContainerPolicyFor<DefaultContainerPolicy, std::string>);
+static_assert(!ContainerPolicyType<int>);
+
+using ReservedMessagePolicy = ContainerPolicy<NodeStorage::Inline, true, 512>;
+using SeqCstPolicy = ContainerPolicy<NodeStorage::Indirect, false, 0, MemoryOrdering::SequentiallyConsistent>;
+
+TEST(ContainerPolicyTest, PoliciesKeepQueueAndStackOrder) {
+    auto check = [](auto queue, auto stack) {
+        for (int i = 0; i < 1000; ++i) {
+            queue->enqueue(i);
+            stack->push(i);
+        }
+        for (int i = 0; i < 1000; ++i) {
+            EXPECT_EQ(queue->dequeue(), i);
+            EXPECT_EQ(stack->pop(), 999 - i);
+        }
+        EXPECT_FALSE(queue->dequeue().has_value());
+        EXPECT_FALSE(stack->pop().has_value());
+    };
+    check(std::make_unique<LockFreeQueue<int, MessageContainerPolicy>>(),
+          std::make_unique<LockFreeStack<int, MessageContainerPolicy>>());
+    check(std::make_unique<LockFreeQueue<int, ReservedMessagePolicy>>(),
+          std::make_unique<LockFreeStack<int, ReservedMessagePolicy>>());
+    check(std::make_unique<LockFreeQueue<int, SeqCstPolicy>>(),
+          std::make_unique<LockFreeStack<int, SeqCstPolicy>>());
+}
+
+TEST(ContainerPolicyTest, InlineQueueUnderContention) {
+    LockFreeQueue<int, ReservedMessagePolicy> queue;
+    std::vector<std::thread> threads;
+    std::atomic<long long> enqueued_sum{0};
+    std::atomic<long long> dequeued_sum{0};
+
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        threads.emplace_back([&queue, &enqueued_sum, i]() {
+            for (int j = 0; j < OPERATIONS_PER_THREAD; ++j) {
+                int value = i * OPERATIONS_PER_THREAD + j;
+                queue.enqueue(value);
+                enqueued_sum.fetch_add(value);
+            }
+        });
+        threads.emplace_back([&queue, &dequeued_sum]() {
+            for (int j = 0; j < OPERATIONS_PER_THREAD; ++j) {
+                std::optional<int> value;
+                while (!(value = queue.dequeue())) {
+                    std::this_thread::yield();
+                }
+                dequeued_sum.fetch_add(*value);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(enqueued_sum.load(), dequeued_sum.load());
+    EXPECT_TRUE(queue.is_empty());
+}
+
+namespace {
+
+struct CountedNode {
+    static inline std::atomic<int> live{0};
+    std::atomic<CountedNode*> next{nullptr};
+
+    CountedNode() { ++live; }
+    ~CountedNode() { --live; }
+};
+
+}
+
+TEST(ContainerPolicyTest, ReserveTakesBackRetiredNodesUpToTheHint) {
+    {
+        detail::NodeReserve<CountedNode, 4> reserve;
+        EXPECT_EQ(CountedNode::live, 4);
+
+        std::vector<CountedNode*> nodes;
+        while (CountedNode* node = reserve.take()) {
+            nodes.push_back(node);
+        }
+        EXPECT_EQ(nodes.size(), 4u);
+        nodes.push_back(new CountedNode());
+        nodes.push_back(new CountedNode());
+
+        // The thread's retired nodes are reclaimed when it exits.
+        std::thread([&reserve, &nodes]() {
+            for (CountedNode* node : nodes) {
+                reserve.retire(node);
+            }
+        }).join();
+        EXPECT_EQ(CountedNode::live, 4);
+
+        nodes.clear();
+        while (CountedNode* node = reserve.take()) {
+            nodes.push_back(node);
+        }
+        EXPECT_EQ(nodes.size(), 4u);
+        for (CountedNode* node : nodes) {
+            delete node;
+        }
+    }
+    EXPECT_EQ(CountedNode::live, 0);
+}
+
+TEST(ContainerPolicyTest, InlineListFindsAndRemoves) {
+    LockFreeList<void*, ContainerPolicy<NodeStorage::Inline, false, 4>> list;
+    int a = 0, b = 0, c = 0;
+    list.insert_beginning(&a);
+    list.insert_beginning(&b);
+    EXPECT_TRUE(list.insert_after(&c, &a));
+    EXPECT_EQ(list.find(&c), &c);
+    EXPECT_TRUE(list.remove(&a));
+    EXPECT_FALSE(list.find(&a).has_value());
+    EXPECT_EQ(list.find(&b), &b);
+}
+
 // Stress test for LockFreeQueue
 std::mutex cout_mutex;
 
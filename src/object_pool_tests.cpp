@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "ObjectPool.h"
+
+namespace {
+
+std::atomic<int> live_objects{0};
+
+struct Tracked {
+    Tracked() { ++live_objects; }
+    ~Tracked() { --live_objects; }
+
+    std::atomic<int> owner{0};
+    int uses = 0;
+};
+
+} // namespace
+
+TEST(ObjectPoolTest, ReleasedObjectsAreReused) {
+    ObjectPool<Tracked> pool;
+    Tracked* first;
+    {
+        auto handle = pool.acquire();
+        first = handle.get();
+        handle->uses++;
+    }
+    auto handle = pool.acquire();
+    EXPECT_EQ(handle.get(), first);
+    EXPECT_EQ(handle->uses, 1);
+
+    ObjectPoolStats stats = pool.stats();
+    EXPECT_EQ(stats.acquired, 2u);
+    EXPECT_EQ(stats.allocated, 1u);
+    EXPECT_EQ(stats.local_hits, 1u);
+    EXPECT_DOUBLE_EQ(stats.hit_rate(), 0.5);
+}
+
+TEST(ObjectPoolTest, RecyclerRunsOnRelease) {
+    ObjectPool<std::vector<int>> pool([] { return std::make_unique<std::vector<int>>(); },
+                                      [](std::vector<int>& v) { v.clear(); });
+    {
+        auto handle = pool.acquire();
+        handle->assign(100, 7);
+    }
+    auto handle = pool.acquire();
+    EXPECT_TRUE(handle->empty());
+    EXPECT_GE(handle->capacity(), 100u);
+}
+
+TEST(ObjectPoolTest, ThreadCachesSpillToSharedFreeList) {
+    ObjectPool<Tracked>::Options options;
+    options.thread_cache_size = 8;
+    ObjectPool<Tracked> pool([] { return std::make_unique<Tracked>(); }, nullptr, options);
+
+    std::thread producer([&pool]() {
+        std::vector<ObjectPool<Tracked>::Handle> handles;
+        for (int i = 0; i < 32; ++i) {
+            handles.push_back(pool.acquire());
+        }
+    });
+    producer.join();
+    // The producer's cache is handed back when it exits.
+    EXPECT_EQ(pool.stats().cached, 32u);
+
+    std::vector<ObjectPool<Tracked>::Handle> handles;
+    for (int i = 0; i < 32; ++i) {
+        handles.push_back(pool.acquire());
+    }
+    ObjectPoolStats stats = pool.stats();
+    EXPECT_EQ(stats.allocated, 32u);
+    EXPECT_EQ(stats.acquired, 64u);
+    EXPECT_GT(stats.global_hits, 0u);
+    EXPECT_EQ(stats.cached, 0u);
+}
+
+TEST(ObjectPoolTest, HighWaterMarkAndTrimBoundCachedObjects) {
+    ObjectPool<Tracked>::Options options;
+    options.thread_cache_size = 4;
+    options.max_cached = 8;
+    {
+        ObjectPool<Tracked> pool([] { return std::make_unique<Tracked>(); }, nullptr, options);
+        {
+            std::vector<ObjectPool<Tracked>::Handle> handles;
+            for (int i = 0; i < 100; ++i) {
+                handles.push_back(pool.acquire());
+            }
+        }
+        EXPECT_LE(pool.stats().cached, 8u + 2u);
+        EXPECT_LE(live_objects.load(), 8 + 2 + 4);
+
+        pool.trim();
+        EXPECT_EQ(pool.stats().cached, 0u);
+        EXPECT_EQ(live_objects.load(), 0);
+    }
+    EXPECT_EQ(live_objects.load(), 0);
+}
+
+TEST(ObjectPoolTest, ConcurrentAcquireAndReleaseHandOutExclusiveObjects) {
+    {
+        ObjectPool<Tracked> pool;
+        std::atomic<bool> shared{false};
+        std::vector<std::thread> threads;
+        for (int t = 1; t <= 8; ++t) {
+            threads.emplace_back([&pool, &shared, t]() {
+                std::vector<ObjectPool<Tracked>::Handle> held;
+                for (int i = 0; i < 20000; ++i) {
+                    auto handle = pool.acquire();
+                    int expected = 0;
+                    if (!handle->owner.compare_exchange_strong(expected, t)) {
+                        shared = true;
+                    }
+                    if (i % 3 == 0) {
+                        held.push_back(std::move(handle));
+                        if (held.size() > 40) {
+                            for (auto& h : held) {
+                                h->owner = 0;
+                            }
+                            held.clear();
+                        }
+                    } else {
+                        handle->owner = 0;
+                    }
+                }
+                for (auto& h : held) {
+                    h->owner = 0;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_FALSE(shared);
+        ObjectPoolStats stats = pool.stats();
+        EXPECT_EQ(stats.acquired, 8u * 20000u);
+        EXPECT_GT(stats.hit_rate(), 0.9);
+    }
+    EXPECT_EQ(live_objects.load(), 0);
+}
+
+TEST(ObjectPoolTest, DestroyedPoolReleasesObjectsCachedByOtherThreads) {
+    auto pool = std::make_unique<ObjectPool<Tracked>>();
+    std::atomic<bool> acquired{false};
+    std::atomic<bool> pool_gone{false};
+    std::thread worker([&]() {
+        { auto handle = pool->acquire(); }
+        acquired = true;
+        while (!pool_gone) {
+            std::this_thread::yield();
+        }
+    });
+    while (!acquired) {
+        std::this_thread::yield();
+    }
+    pool.reset();
+    pool_gone = true;
+    worker.join();
+    EXPECT_EQ(live_objects.load(), 0);
+}
+
+TEST(BufferPoolTest, RequestsAreRoundedUpToSizeClasses) {
+    BufferPool pool(256, 4096);
+    EXPECT_EQ(pool.size_classes(), 5u);
+
+    std::byte* first;
+    {
+        auto buffer = pool.acquire(300);
+        EXPECT_EQ(buffer->size(), 512u);
+        first = buffer->data();
+    }
+    EXPECT_EQ(pool.acquire(400)->data(), first);
+    EXPECT_EQ(pool.acquire(1)->size(), 256u);
+    EXPECT_EQ(pool.acquire(4096)->size(), 4096u);
+
+    auto large = pool.acquire(10000);
+    EXPECT_EQ(large->size(), 10000u);
+    large.reset();
+    EXPECT_EQ(pool.stats().allocated, 3u);
+}
+
+TEST(BufferPoolTest, ResizedBuffersGetTheirClassSizeBack) {
+    BufferPool pool(256, 4096);
+    {
+        auto buffer = pool.acquire(512);
+        buffer->clear();
+    }
+    {
+        auto buffer = pool.acquire(512);
+        EXPECT_EQ(buffer->size(), 512u);
+        buffer->resize(100000);
+    }
+    EXPECT_EQ(pool.acquire(512)->size(), 512u);
+    EXPECT_EQ(pool.stats().allocated, 1u);
+}
@@ -0,0 +1,306 @@
+#ifndef ASYNC_SCHEDULE_HOOKS
+#error "schedule_exploration_tests.cpp must be built with ASYNC_SCHEDULE_HOOKS defined"
+#endif
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "LockFreeList.h"
+#include "LockFreeQueue.h"
+#include "LockFreeStack.h"
+#include "LockFreeTaskQueue.h"
+#include "ScheduleExplorer.h"
+#include "ThreadPool.h"
+
+// Each test runs a few short threads against one container under many
+// seeded schedules and checks the recorded history for linearizability.
+// A failure reports its seed; rerun with ASYNC_SCHEDULE_SEED=<seed> to
+// replay that schedule.
+
+namespace {
+
+const std::uint64_t SCHEDULES = 2000;
+
+struct ContainerOp {
+    enum Kind { Push, Pop, InsertFront, InsertAfter, Remove, Find } kind;
+    int value = 0;
+    int after = 0;
+    std::optional<int> popped;
+    bool succeeded = false;
+};
+
+struct QueueModel {
+    std::deque<int> items;
+
+    bool apply(const ContainerOp& op) {
+        if (op.kind == ContainerOp::Push) {
+            items.push_back(op.value);
+            return true;
+        }
+        if (items.empty()) {
+            return !op.popped;
+        }
+        if (op.popped != items.front()) {
+            return false;
+        }
+        items.pop_front();
+        return true;
+    }
+};
+
+struct StackModel {
+    std::vector<int> items;
+
+    bool apply(const ContainerOp& op) {
+        if (op.kind == ContainerOp::Push) {
+            items.push_back(op.value);
+            return true;
+        }
+        if (items.empty()) {
+            return !op.popped;
+        }
+        if (op.popped != items.back()) {
+            return false;
+        }
+        items.pop_back();
+        return true;
+    }
+};
+
+// Values in the list tests are distinct, so "first match" is unambiguous.
+struct ListModel {
+    std::vector<int> items;
+
+    bool apply(const ContainerOp& op) {
+        auto it = std::find(items.begin(), items.end(), op.kind == ContainerOp::InsertAfter ? op.after : op.value);
+        bool found = it != items.end();
+        switch (op.kind) {
+            case ContainerOp::InsertFront:
+                items.insert(items.begin(), op.value);
+                return true;
+            case ContainerOp::InsertAfter:
+                if (found) {
+                    items.insert(it + 1, op.value);
+                }
+                return op.succeeded == found;
+            case ContainerOp::Remove:
+                if (found) {
+                    items.erase(it);
+                }
+                return op.succeeded == found;
+            case ContainerOp::Find:
+                return op.succeeded == found;
+            default:
+                return false;
+        }
+    }
+};
+
+ContainerOp op(ContainerOp::Kind kind, int value = 0, int after = 0) {
+    ContainerOp result;
+    result.kind = kind;
+    result.value = value;
+    result.after = after;
+    return result;
+}
+
+} // namespace
+
+TEST(ScheduleExplorationTest, ControlledScheduleIsReproducible) {
+    auto trace = [](std::uint64_t seed) {
+        std::vector<int> order;
+        ControlledScheduler scheduler(seed);
+        std::vector<std::function<void()>> bodies;
+        for (int t = 0; t < 3; ++t) {
+            bodies.push_back([&order, t]() {
+                for (int i = 0; i < 5; ++i) {
+                    order.push_back(t);
+                    ASYNC_SCHEDULE_POINT();
+                }
+            });
+        }
+        scheduler.run(std::move(bodies));
+        return order;
+    };
+
+    EXPECT_EQ(trace(7), trace(7));
+    bool differs = false;
+    for (std::uint64_t seed = 1; seed < 10 && !differs; ++seed) {
+        differs = trace(seed) != trace(seed + 1);
+    }
+    EXPECT_TRUE(differs);
+}
+
+TEST(ScheduleExplorationTest, LinearizabilityCheckRejectsImpossibleHistories) {
+    History<ContainerOp> history;
+    history.record(op(ContainerOp::Push, 1), [](ContainerOp&) {});
+    history.record(op(ContainerOp::Push, 2), [](ContainerOp&) {});
+    history.record(op(ContainerOp::Pop), [](ContainerOp& o) { o.popped = 2; });
+    EXPECT_TRUE(is_linearizable(history, StackModel()));
+    EXPECT_FALSE(is_linearizable(history, QueueModel()));
+}
+
+TEST(ScheduleExplorationTest, LockFreeQueueIsLinearizable) {
+    auto failed = explore_seeds(SCHEDULES, [](std::uint64_t seed) {
+        LockFreeQueue<int> queue;
+        History<ContainerOp> history;
+        ControlledScheduler scheduler(seed);
+        std::vector<std::function<void()>> bodies;
+        for (int t = 0; t < 3; ++t) {
+            bodies.push_back([&queue, &history, t]() {
+                for (int i = 0; i < 2; ++i) {
+                    history.record(op(ContainerOp::Push, t * 10 + i), [&queue](ContainerOp& o) {
+                        queue.enqueue(o.value);
+                    });
+                    history.record(op(ContainerOp::Pop), [&queue](ContainerOp& o) {
+                        o.popped = queue.dequeue();
+                    });
+                }
+            });
+        }
+        scheduler.run(std::move(bodies));
+        return is_linearizable(history, QueueModel()) && queue.is_empty();
+    });
+    EXPECT_FALSE(failed) << "seed " << *failed;
+}
+
+TEST(ScheduleExplorationTest, LockFreeStackIsLinearizable) {
+    auto failed = explore_seeds(SCHEDULES, [](std::uint64_t seed) {
+        LockFreeStack<int> stack;
+        History<ContainerOp> history;
+        ControlledScheduler scheduler(seed);
+        std::vector<std::function<void()>> bodies;
+        for (int t = 0; t < 3; ++t) {
+            bodies.push_back([&stack, &history, t]() {
+                for (int i = 0; i < 2; ++i) {
+                    history.record(op(ContainerOp::Push, t * 10 + i), [&stack](ContainerOp& o) {
+                        stack.push(o.value);
+                    });
+                    history.record(op(ContainerOp::Pop), [&stack](ContainerOp& o) {
+                        o.popped = stack.pop();
+                    });
+                }
+            });
+        }
+        scheduler.run(std::move(bodies));
+        return is_linearizable(history, StackModel()) && stack.is_empty();
+    });
+    EXPECT_FALSE(failed) << "seed " << *failed;
+}
+
+TEST(ScheduleExplorationTest, LockFreeListIsLinearizable) {
+    auto failed = explore_seeds(SCHEDULES, [](std::uint64_t seed) {
+        LockFreeList<int> list;
+        History<ContainerOp> history;
+        ControlledScheduler scheduler(seed);
+        list.insert_beginning(2);
+        list.insert_beginning(1);
+        ListModel initial{{1, 2}};
+
+        auto insert_after = [&list, &history](int value, int after) {
+            history.record(op(ContainerOp::InsertAfter, value, after), [&list](ContainerOp& o) {
+                o.succeeded = list.insert_after(o.value, o.after);
+            });
+        };
+        auto remove = [&list, &history](int value) {
+            history.record(op(ContainerOp::Remove, value), [&list](ContainerOp& o) {
+                o.succeeded = list.remove(o.value);
+            });
+        };
+        auto find = [&list, &history](int value) {
+            history.record(op(ContainerOp::Find, value), [&list](ContainerOp& o) {
+                o.succeeded = list.find(o.value).has_value();
+            });
+        };
+
+        scheduler.run({
+            [&]() { insert_after(10, 1); remove(2); find(20); },
+            [&]() { remove(1); insert_after(20, 2); find(10); },
+            [&]() {
+                history.record(op(ContainerOp::InsertFront, 30), [&list](ContainerOp& o) {
+                    list.insert_beginning(o.value);
+                });
+                insert_after(40, 10);
+                remove(30);
+            },
+        });
+        // Inserts that were reported as done must be visible afterwards.
+        for (int value : {1, 2, 10, 20, 30, 40}) {
+            find(value);
+        }
+        return is_linearizable(history, initial);
+    });
+    EXPECT_FALSE(failed) << "seed " << *failed;
+}
+
+TEST(ScheduleExplorationTest, LockFreeTaskQueueDeliversEveryTaskOnce) {
+    auto failed = explore_seeds(200, [](std::uint64_t seed) {
+        RandomYieldScheduler scheduler(seed, 2);
+        LockFreeTaskQueue queue;
+        std::atomic<int> ran{0};
+        std::vector<std::thread> consumers;
+        for (int i = 0; i < 2; ++i) {
+            consumers.emplace_back([&queue]() {
+                LockFreeTaskQueue::Task task;
+                while (queue.pop(task)) {
+                    task();
+                }
+            });
+        }
+        std::vector<std::thread> producers;
+        for (int i = 0; i < 2; ++i) {
+            producers.emplace_back([&queue, &ran]() {
+                for (int j = 0; j < 50; ++j) {
+                    queue.push([&ran]() { ran++; });
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        queue.stop();
+        for (auto& consumer : consumers) {
+            consumer.join();
+        }
+        return ran == 100;
+    });
+    EXPECT_FALSE(failed) << "seed " << *failed;
+}
+
+TEST(ScheduleExplorationTest, BoundedThreadPoolAccountsForEveryTask) {
+    for (OverflowPolicy policy : {OverflowPolicy::Block, OverflowPolicy::Reject, OverflowPolicy::DropOldest,
+                                  OverflowPolicy::CallerRuns}) {
+        auto failed = explore_seeds(100, [policy](std::uint64_t seed) {
+            RandomYieldScheduler scheduler(seed, 2);
+            std::atomic<int> ran{0};
+            std::atomic<int> dropped{0};
+            std::atomic<int> refused{0};
+            {
+                ThreadPool pool(2, 4, policy);
+                std::vector<std::thread> producers;
+                for (int i = 0; i < 2; ++i) {
+                    producers.emplace_back([&]() {
+                        for (int j = 0; j < 40; ++j) {
+                            auto task = pool.guard_drop([&ran]() { ran++; }, [&dropped]() { dropped++; });
+                            if (!pool.try_enqueue(std::move(task))) {
+                                refused++;
+                            }
+                        }
+                    });
+                }
+                for (auto& producer : producers) {
+                    producer.join();
+                }
+                while (pool.get_queued_count() != 0) {
+                    std::this_thread::yield();
+                }
+            }
+            return ran + dropped + refused == 80;
+        });
+        EXPECT_FALSE(failed) << "policy " << static_cast<int>(policy) << ", seed " << *failed;
+    }
+}
@@ -0,0 +1,280 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "SharedMemoryQueue.h"
+
+namespace {
+
+struct Job {
+    std::uint32_t id;
+    std::uint32_t weight;
+    char tag[8];
+};
+
+std::string segment_name(const std::string& test) {
+    return "/async_shmq_" + test + "_" + std::to_string(::getpid());
+}
+
+// Runs body in a child process and returns its exit status. The child never
+// returns into the test runner.
+template<typename Body>
+int run_child(Body&& body) {
+    pid_t child = ::fork();
+    if (child == 0) {
+        int status = 3;
+        try {
+            status = body();
+        } catch (...) {
+            status = 2;
+        }
+        ::_exit(status);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+} // namespace
+
+TEST(SharedMemoryQueueTest, KeepsOrderAcrossLaps) {
+    auto queue = SharedMemoryQueue<Job>::create(segment_name("order"), 3);
+    ASSERT_EQ(queue.capacity(), 4u);
+
+    std::uint32_t next_in = 0;
+    std::uint32_t next_out = 0;
+    for (int lap = 0; lap < 100; ++lap) {
+        while (queue.try_push(Job{next_in, 1, "lap"})) {
+            ++next_in;
+        }
+        EXPECT_EQ(queue.size(), 4u);
+        Job job{};
+        for (int i = 0; i < 3 && queue.try_pop(job); ++i) {
+            EXPECT_EQ(job.id, next_out++);
+        }
+    }
+    Job job{};
+    while (queue.try_pop(job)) {
+        EXPECT_EQ(job.id, next_out++);
+    }
+    EXPECT_EQ(next_in, next_out);
+    EXPECT_EQ(queue.abandoned(), 0u);
+}
+
+TEST(SharedMemoryQueueTest, OpenChecksTheSegment) {
+    std::string name = segment_name("open");
+    EXPECT_THROW(SharedMemoryQueue<Job>::open(name), std::system_error);
+
+    auto queue = SharedMemoryQueue<Job>::create(name, 8);
+    EXPECT_THROW(SharedMemoryQueue<Job>::create(name, 8), std::system_error);
+    EXPECT_THROW(SharedMemoryQueue<std::uint64_t>::open(name), std::runtime_error);
+
+    auto other = SharedMemoryQueue<Job>::open(name);
+    ASSERT_TRUE(queue.try_push(Job{7, 1, "x"}));
+    Job job{};
+    ASSERT_TRUE(other.try_pop(job));
+    EXPECT_EQ(job.id, 7u);
+}
+
+TEST(SharedMemoryQueueTest, PopTimesOutAndStops) {
+    auto queue = SharedMemoryQueue<Job>::create(segment_name("stop"), 2);
+    Job job{};
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(queue.pop_for(job, std::chrono::milliseconds(20)));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+
+    ASSERT_TRUE(queue.try_push(Job{1, 1, "a"}));
+    queue.stop();
+    EXPECT_FALSE(queue.push(Job{2, 1, "b"}));
+    EXPECT_TRUE(queue.pop(job));
+    EXPECT_FALSE(queue.pop(job));
+}
+
+// The child blocks in pop() and the parent in push() on a small queue, so
+// both futex wakeup directions cross the process boundary.
+TEST(SharedMemoryQueueTest, HandsRecordsToAnotherProcess) {
+    std::string name = segment_name("handoff");
+    auto queue = SharedMemoryQueue<Job>::create(name, 16);
+    auto results = SharedMemoryQueue<std::uint64_t>::create(name + "_results", 2);
+    const std::uint32_t count = 20000;
+
+    pid_t child = ::fork();
+    if (child == 0) {
+        int status = 2;
+        try {
+            auto jobs = SharedMemoryQueue<Job>::open(name);
+            auto sums = SharedMemoryQueue<std::uint64_t>::open(name + "_results");
+            std::uint64_t sum = 0;
+            std::uint32_t expected = 0;
+            Job job{};
+            status = 0;
+            while (jobs.pop(job)) {
+                if (job.id != expected++) {
+                    status = 1;
+                }
+                sum += job.weight;
+            }
+            sums.push(sum);
+        } catch (...) {
+        }
+        ::_exit(status);
+    }
+
+    for (std::uint32_t i = 0; i < count; ++i) {
+        ASSERT_TRUE(queue.push(Job{i, i % 7, "job"}));
+    }
+    queue.stop();
+
+    std::uint64_t sum = 0;
+    EXPECT_TRUE(results.pop_for(sum, std::chrono::seconds(30)));
+    std::uint64_t expected = 0;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        expected += i % 7;
+    }
+    EXPECT_EQ(sum, expected);
+
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(SharedMemoryQueueTest, ManyProducerProcessesAndConsumerThreads) {
+    std::string name = segment_name("mpmc");
+    auto queue = SharedMemoryQueue<Job>::create(name, 8);
+    const std::uint32_t per_producer = 5000;
+
+    std::vector<pid_t> producers;
+    for (std::uint32_t p = 0; p < 2; ++p) {
+        pid_t child = ::fork();
+        if (child == 0) {
+            int status = 2;
+            try {
+                auto jobs = SharedMemoryQueue<Job>::open(name);
+                status = 0;
+                for (std::uint32_t i = 0; i < per_producer; ++i) {
+                    if (!jobs.push(Job{p * per_producer + i, 1, "mp"})) {
+                        status = 1;
+                    }
+                }
+            } catch (...) {
+            }
+            ::_exit(status);
+        }
+        producers.push_back(child);
+    }
+
+    std::atomic<std::uint64_t> id_sum{0};
+    std::atomic<std::uint32_t> received{0};
+    std::vector<std::thread> consumers;
+    for (int c = 0; c < 2; ++c) {
+        consumers.emplace_back([&queue, &id_sum, &received]() {
+            Job job{};
+            while (queue.pop(job)) {
+                id_sum.fetch_add(job.id);
+                received.fetch_add(1);
+            }
+        });
+    }
+
+    for (pid_t producer : producers) {
+        int status = 0;
+        ::waitpid(producer, &status, 0);
+        EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    queue.stop();
+    for (auto& consumer : consumers) {
+        consumer.join();
+    }
+
+    std::uint64_t total = 2 * per_producer;
+    EXPECT_EQ(received.load(), total);
+    EXPECT_EQ(id_sum.load(), total * (total - 1) / 2);
+    EXPECT_EQ(queue.abandoned(), 0u);
+}
+
+TEST(SharedMemoryQueueTest, SkipsSlotOfWriterThatDied) {
+    std::string name = segment_name("dead_writer");
+    auto queue = SharedMemoryQueue<Job>::create(name, 4);
+
+    int status = run_child([&name]() {
+        auto jobs = SharedMemoryQueue<Job>::open(name);
+        jobs.try_emplace([](Job& job) {
+            job.id = 99;
+            ::_exit(0);
+        });
+        return 1;
+    });
+    ASSERT_EQ(status, 0);
+
+    ASSERT_TRUE(queue.try_push(Job{1, 1, "after"}));
+    Job job{};
+    ASSERT_TRUE(queue.pop_for(job, std::chrono::seconds(5)));
+    EXPECT_EQ(job.id, 1u);
+    EXPECT_EQ(queue.abandoned(), 1u);
+    EXPECT_FALSE(queue.try_pop(job));
+}
+
+TEST(SharedMemoryQueueTest, ReclaimsSlotOfReaderThatDied) {
+    std::string name = segment_name("dead_reader");
+    auto queue = SharedMemoryQueue<Job>::create(name, 2);
+    ASSERT_TRUE(queue.try_push(Job{1, 1, "a"}));
+    ASSERT_TRUE(queue.try_push(Job{2, 1, "b"}));
+
+    int status = run_child([&name]() {
+        auto jobs = SharedMemoryQueue<Job>::open(name);
+        jobs.try_consume([](const Job&) { ::_exit(0); });
+        return 1;
+    });
+    ASSERT_EQ(status, 0);
+
+    Job job{};
+    ASSERT_TRUE(queue.try_pop(job));
+    EXPECT_EQ(job.id, 2u);
+    EXPECT_TRUE(queue.push_for(Job{3, 1, "c"}, std::chrono::seconds(5)));
+    EXPECT_TRUE(queue.try_push(Job{4, 1, "d"}));
+    EXPECT_EQ(queue.abandoned(), 1u);
+    ASSERT_TRUE(queue.try_pop(job));
+    EXPECT_EQ(job.id, 3u);
+    ASSERT_TRUE(queue.try_pop(job));
+    EXPECT_EQ(job.id, 4u);
+}
+
+// A consumer killed while parked in pop() must not leave producers making a
+// futex call on every push.
+TEST(SharedMemoryQueueTest, ForgetsWaiterThatDiedWhileParked) {
+    std::string name = segment_name("dead_waiter");
+    auto queue = SharedMemoryQueue<Job>::create(name, 4);
+
+    pid_t child = ::fork();
+    if (child == 0) {
+        auto jobs = SharedMemoryQueue<Job>::open(name);
+        Job job{};
+        jobs.pop(job);
+        ::_exit(0);
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (queue.waiting() != 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(queue.waiting(), 1u);
+    ::kill(child, SIGKILL);
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    ASSERT_TRUE(WIFSIGNALED(status));
+
+    // The first push finds nobody to wake and frees the dead waiter's entry.
+    ASSERT_TRUE(queue.try_push(Job{1, 1, "a"}));
+    EXPECT_EQ(queue.waiting(), 0u);
+    Job job{};
+    ASSERT_TRUE(queue.try_pop(job));
+    EXPECT_EQ(job.id, 1u);
+    EXPECT_EQ(queue.abandoned(), 0u);
+}
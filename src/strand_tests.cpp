@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "Strand.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+void wait_for(const std::atomic<int>& counter, int expected) {
+    auto deadline = std::chrono::steady_clock::now() + 10s;
+    while (counter.load() != expected && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+}
+}
+
+TEST(StrandTest, RunsTasksInPostingOrderWithoutOverlap) {
+    ThreadPool pool(4);
+    Strand strand(pool, 8);
+    std::vector<int> order;
+    std::atomic<int> active{0};
+    std::atomic<bool> overlapped{false};
+    std::atomic<int> done{0};
+
+    for (int i = 0; i < 1000; ++i) {
+        strand.post([i, &order, &active, &overlapped, &done]() {
+            if (active.fetch_add(1) != 0) {
+                overlapped = true;
+            }
+            order.push_back(i);
+            active.fetch_sub(1);
+            done++;
+        });
+    }
+    wait_for(done, 1000);
+
+    EXPECT_FALSE(overlapped);
+    ASSERT_EQ(order.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+}
+
+TEST(StrandTest, PreservesPerProducerOrderUnderConcurrentPosts) {
+    ThreadPool pool(4);
+    Strand strand(pool);
+    const int producers = 4;
+    const int per_producer = 2000;
+    std::vector<int> last(producers, -1);
+    std::atomic<bool> out_of_order{false};
+    std::atomic<int> done{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([p, &strand, &last, &out_of_order, &done]() {
+            for (int i = 0; i < per_producer; ++i) {
+                strand.post([p, i, &last, &out_of_order, &done]() {
+                    // Unsynchronised access is safe because strand tasks
+                    // never overlap.
+                    if (last[p] != i - 1) {
+                        out_of_order = true;
+                    }
+                    last[p] = i;
+                    done++;
+                });
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    wait_for(done, producers * per_producer);
+    EXPECT_FALSE(out_of_order);
+}
+
+TEST(StrandTest, ManyStrandsShareOnePool) {
+    ThreadPool pool(4);
+    std::vector<std::unique_ptr<Strand>> strands;
+    std::vector<int> counters(2000, 0);
+    std::atomic<int> done{0};
+    for (int s = 0; s < 2000; ++s) {
+        strands.push_back(std::make_unique<Strand>(pool));
+    }
+
+    for (int round = 0; round < 10; ++round) {
+        for (int s = 0; s < 2000; ++s) {
+            strands[s]->post([s, &counters, &done]() {
+                counters[s]++;
+                done++;
+            });
+        }
+    }
+    wait_for(done, 20000);
+    for (int count : counters) {
+        EXPECT_EQ(count, 10);
+    }
+}
+
+TEST(StrandTest, DispatchRunsInlineInsideStrand) {
+    ThreadPool pool(2);
+    Strand strand(pool);
+    std::atomic<int> done{0};
+    std::vector<int> order;
+
+    EXPECT_FALSE(strand.running_in_this_thread());
+    strand.post([&strand, &order, &done]() {
+        EXPECT_TRUE(strand.running_in_this_thread());
+        strand.dispatch([&order]() { order.push_back(1); });
+        order.push_back(2);
+        done++;
+    });
+    wait_for(done, 1);
+    EXPECT_EQ(order, std::vector<int>({1, 2}));
+}
+
+TEST(StrandTest, ThrowingTaskDoesNotStallStrand) {
+    ThreadPool pool(2);
+    Strand strand(pool);
+    std::atomic<int> done{0};
+
+    strand.post([]() { throw std::runtime_error("strand task failure"); });
+    strand.post([&done]() { done++; });
+    wait_for(done, 1);
+    EXPECT_EQ(done, 1);
+}
+
+TEST(StrandTest, RefusedDrainRunsOnPostingThread) {
+    ThreadPool pool(1, 1, OverflowPolicy::Reject);
+    std::atomic<bool> release{false};
+    pool.enqueue([&release]() {
+        while (!release) {
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+    while (pool.get_idle_thread_count() != 0) {
+        std::this_thread::yield();
+    }
+    pool.enqueue([]() {});
+
+    Strand strand(pool);
+    std::thread::id ran_on;
+    strand.post([&ran_on]() { ran_on = std::this_thread::get_id(); });
+    EXPECT_EQ(ran_on, std::this_thread::get_id());
+    release = true;
+}